@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <GUnit.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr auto STEPS = 100000;
+constexpr auto RUNS = 10;
+constexpr auto PATTERN = "I transfer {amount} from {account} to {account} at {rate} in {days} days";
+
+template <class T>
+auto stream_cast(const std::string& str) {
+  T var;
+  std::istringstream iss;
+  iss.str(str);
+  iss >> var;
+  return var;
+}
+
+template <class T>
+auto benchmark(const std::string& name, const T& expr) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto sum = 0.;
+  for (auto i = 0; i < RUNS; ++i) {
+    sum += expr();
+  }
+  const auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+  std::cout << name << ": " << ms << " ms (" << STEPS * 5 << " arguments)" << std::endl;
+  return sum / RUNS;
+}
+}  // namespace
+
+GTEST("Arguments") {
+  std::vector<std::string> steps{};
+  std::vector<std::vector<std::string>> matches{};
+  for (auto i = 0; i < STEPS; ++i) {
+    steps.push_back("I transfer " + std::to_string(i) + " from acc" + std::to_string(i) + " to acc" + std::to_string(i + 1) +
+                    " at " + std::to_string(i % 100) + ".25 in " + std::to_string(i % 30) + " days");
+    matches.push_back(testing::detail::matches(std::string{PATTERN}, steps.back()));
+  }
+
+  SHOULD("capture step arguments with compile-time patterns") {
+    const auto runtime = benchmark("matches      ", [&] {
+      auto sum = 0.;
+      for (const auto& step : steps) {
+        sum += testing::detail::matches(std::string{PATTERN}, step)[1].size();
+      }
+      return sum;
+    });
+
+    const auto compiled = benchmark("compiled     ", [&] {
+      using pattern = testing::detail::compiled_pattern<decltype(
+          "I transfer {amount} from {account} to {account} at {rate} in {days} days"_gtest_string)>;
+      auto sum = 0.;
+      pattern::captures_t captures{};
+      for (const auto& step : steps) {
+        pattern::match(step, captures);
+        sum += captures[1].size();
+      }
+      return sum;
+    });
+
+    EXPECT_DOUBLE_EQ(runtime, compiled);
+  }
+
+  SHOULD("convert step arguments without streams") {
+    const auto streams = benchmark("istringstream", [&] {
+      auto sum = 0.;
+      for (const auto& m : matches) {
+        sum += stream_cast<int>(m[0]) + stream_cast<std::string>(m[1]).size() + stream_cast<std::string>(m[2]).size() +
+               stream_cast<double>(m[3]) + stream_cast<unsigned>(m[4]);
+      }
+      return sum;
+    });
+
+    const auto lexical = benchmark("lexical_cast ", [&] {
+      using testing::detail::lexical_cast;
+      auto sum = 0.;
+      for (const auto& m : matches) {
+        sum += lexical_cast<int>(m[0]) + lexical_cast<testing::detail::string_view>(m[1]).size() +
+               lexical_cast<const std::string&>(m[2]).size() + lexical_cast<double>(m[3]) + lexical_cast<unsigned>(m[4]);
+      }
+      return sum;
+    });
+
+    EXPECT_DOUBLE_EQ(streams, lexical);
+  }
+}
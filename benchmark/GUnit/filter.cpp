@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <GUnit.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr auto TESTS = 10000;
+constexpr auto RUNS = 10;
+
+auto make_names() {
+  std::vector<std::string> names{};
+  for (auto i = 0; i < TESTS; ++i) {
+    names.push_back("Calc" + std::to_string(i % 97) + ".should add " + std::to_string(i) +
+                    " numbers and print the result on the screen when the " + (i % 2 ? "divide" : "add") + " is pressed");
+  }
+  return names;
+}
+
+template <class T>
+auto benchmark(const std::string& name, const T& expr) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto matched = 0;
+  for (auto i = 0; i < RUNS; ++i) {
+    matched += expr();
+  }
+  const auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+  std::cout << name << ": " << ms << " ms (" << matched / RUNS << '/' << TESTS << " matched)" << std::endl;
+  return matched / RUNS;
+}
+}  // namespace
+
+GTEST("Filter") {
+  const auto names = make_names();
+
+  const auto match = [&](const std::string& flag) {
+    const auto compiled = benchmark("compiled   [" + flag + "]", [&] {
+      const testing::detail::filter f{flag};
+      auto matched = 0;
+      for (const auto& name : names) {
+        matched += f.matches(name);
+      }
+      return matched;
+    });
+
+    const auto uncompiled = benchmark("uncompiled [" + flag + "]", [&] {
+      auto matched = 0;
+      for (const auto& name : names) {
+        matched += testing::detail::FilterMatchesShould(name, flag);
+      }
+      return matched;
+    });
+
+    EXPECT_EQ(uncompiled, compiled);
+  };
+
+  SHOULD("match everything") { match("*"); }
+  SHOULD("match with many wildcards") { match("Calc1*.*add*numbers*screen*-*divide*"); }
+  SHOULD("match with many patterns") { match("*a*a*a*a*a*a*a*a*z:*1*2*-*3*4*5*"); }
+  SHOULD("match literal and glob patterns") { match("Calc42.should add 42 numbers*:*d*i*v*i*d*e*"); }
+}
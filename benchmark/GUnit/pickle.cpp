@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <GUnit.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr auto SCENARIOS = 1000;
+constexpr auto STEPS = 10;
+constexpr auto ROWS = 5;
+constexpr auto RUNS = 10;
+
+auto make_feature() {
+  std::wstring feature{L"Feature: Benchmark\n"};
+  for (auto i = 0; i < SCENARIOS; ++i) {
+    feature += L"  Scenario: Scenario " + std::to_wstring(i) + L"\n";
+    feature += L"    Given I have the following table\n      | id | desc | value |\n";
+    for (auto row = 0; row < ROWS; ++row) {
+      feature += L"      | " + std::to_wstring(row) + L" | description " + std::to_wstring(row) + L" | " +
+                 std::to_wstring(row * i) + L" |\n";
+    }
+    for (auto step = 1; step < STEPS; ++step) {
+      feature += L"    When I press the button number " + std::to_wstring(step) + L"\n";
+    }
+  }
+  return feature;
+}
+
+template <class T>
+auto benchmark(const std::string& name, const T& expr) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto cells = 0ul;
+  for (auto i = 0; i < RUNS; ++i) {
+    cells += expr();
+  }
+  const auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+  std::cout << name << ": " << ms << " ms (" << SCENARIOS * STEPS << " steps)" << std::endl;
+  return cells / RUNS;
+}
+}  // namespace
+
+GTEST("Pickle") {
+  gherkin::parser parser{L"en"};
+  gherkin::compiler compiler{"benchmark.feature"};
+  const auto pickles = compiler.compile(parser.parse(make_feature()));
+  ASSERT_EQ(std::size_t(SCENARIOS), pickles.size());
+
+  SHOULD("run scenarios without parsing json") {
+    std::vector<std::shared_ptr<const testing::detail::pickle>> parsed{};
+    benchmark("convert once", [&] {
+      parsed.clear();
+      for (const auto& pickle : pickles) {
+        parsed.push_back(std::make_shared<const testing::detail::pickle>(nlohmann::json::parse(pickle)["pickle"]));
+      }
+      return 0ul;
+    });
+
+    const auto json = benchmark("json per run", [&] {
+      auto cells = 0ul;
+      for (const auto& pickle : pickles) {
+        const auto json = nlohmann::json::parse(pickle)["pickle"];
+        for (const auto& step : json["steps"]) {
+          cells += step["text"].get<std::string>().size();
+          for (const auto& argument : step["arguments"]) {
+            const auto rows = argument["rows"].size();
+            cells += rows ? rows - 1 : 0;  // without the header
+          }
+        }
+      }
+      return cells;
+    });
+
+    const auto preparsed = benchmark("pre-parsed  ", [&] {
+      auto cells = 0ul;
+      for (const auto& pickle : parsed) {
+        for (const auto& step : pickle->steps()) {
+          cells += pickle->str(step).size() + pickle->table(step).size();
+        }
+      }
+      return cells;
+    });
+
+    EXPECT_EQ(json, preparsed);
+  }
+}
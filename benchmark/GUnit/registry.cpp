@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <GUnit.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr auto DEFINITIONS = 2000;
+constexpr auto SCENARIOS = 1000;
+constexpr auto STEPS = 5;
+
+template <class T>
+auto benchmark(const std::string& name, const T& expr) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto calls = expr();
+  const auto ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+  std::cout << name << ": " << ms << " ms (" << SCENARIOS << " scenarios, " << DEFINITIONS << " steps definitions)"
+            << std::endl;
+  return calls;
+}
+}  // namespace
+
+GTEST("Registry") {
+  std::vector<std::string> patterns{};
+  for (auto i = 0; i < DEFINITIONS; ++i) {
+    patterns.push_back("I have {n} items of kind " + std::to_string(i));
+  }
+
+  nlohmann::json json{};
+  for (auto i = 0; i < STEPS; ++i) {
+    json["steps"].push_back({{"text", "I have " + std::to_string(i) + " items of kind " + std::to_string(i * 100)},
+                             {"arguments", nlohmann::json::array()},
+                             {"locations", {{{"line", i + 1}, {"column", 1}}}}});
+  }
+  const auto pickle = std::make_shared<const testing::detail::pickle>(json);
+
+  auto calls = 0;
+  const auto steps = [&](testing::Steps steps) {
+    for (const auto& pattern : patterns) {
+      steps.Given(pattern.c_str()) = [&](int n) { calls += n; };
+    }
+    return steps;
+  };
+
+  SHOULD("reuse compiled steps between scenarios") {
+    testing::SetReporter(std::make_unique<testing::detail::quiet_reporter>());
+
+    const auto run = [&](const std::shared_ptr<testing::detail::step_registry>& registry) {
+      calls = 0;
+      for (auto i = 0; i < SCENARIOS; ++i) {
+        testing::detail::call_steps(steps, pickle, "benchmark.feature", registry, {},
+                                    testing::detail::type_list<testing::Steps>{});
+      }
+      return calls;
+    };
+
+    const auto rebuilt = benchmark("rebuilt", [&] { return run({}); });
+    const auto reused = benchmark("reused ", [&] { return run(std::make_shared<testing::detail::step_registry>()); });
+    EXPECT_EQ(rebuilt, reused);
+  }
+}
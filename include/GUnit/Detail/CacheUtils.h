@@ -0,0 +1,348 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GUnit/Detail/FileUtils.h"
+#include "GUnit/Detail/ProgUtils.h"
+#include "GUnit/Detail/ReportUtils.h"
+#include "GUnit/Detail/StringUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Fingerprints of passed tests, stored as an array of records which is mapped on load
+ */
+class test_cache {
+  struct record {
+    std::uint64_t name;
+    std::uint64_t fingerprint;
+  };
+
+ public:
+  explicit test_cache(const std::string& path) : path_{path} {
+    const mapped_file file{path};
+    const auto records = reinterpret_cast<const record*>(file.data());
+    for (auto i = 0u; i < file.size() / sizeof(record); ++i) {
+      passed_[records[i].name] = records[i].fingerprint;
+    }
+  }
+
+  bool passed(const std::string& name, std::uint64_t fingerprint) const {
+    const auto it = passed_.find(hash(name));
+    return it != passed_.end() && it->second == fingerprint;
+  }
+
+  void update(const std::string& name, std::uint64_t fingerprint, bool passed) {
+    if (passed) {
+      passed_[hash(name)] = fingerprint;
+    } else {
+      passed_.erase(hash(name));
+    }
+  }
+
+  void save() const {
+    const auto dir = path_.find_last_of('/');
+    if (dir != std::string::npos) {
+      ::mkdir(path_.substr(0, dir).c_str(), 0755);
+    }
+    const auto tmp = path_ + ".tmp";
+    std::unique_ptr<FILE, decltype(&std::fclose)> file{std::fopen(tmp.c_str(), "wb"), &std::fclose};
+    if (not file) {
+      return;
+    }
+    for (const auto& passed : passed_) {
+      const record r{passed.first, passed.second};
+      std::fwrite(&r, sizeof(r), 1, file.get());
+    }
+    file.reset();
+    std::rename(tmp.c_str(), path_.c_str());
+  }
+
+ private:
+  std::string path_{};
+  std::unordered_map<std::uint64_t, std::uint64_t> passed_{};
+};
+
+/**
+ * Append-only binary cache of values computed from files, keyed by path and validated by size, mtime and content hash
+ *
+ * The cache file is mapped and indexed on load, values are returned as views into the mapping.
+ * Updated files are appended on save, the file is rewritten when most of it is stale. get/put are thread safe.
+ */
+class file_cache {
+  struct stamp {
+    std::uint64_t size;
+    std::uint64_t mtime;
+    std::uint64_t hash;
+  };
+
+  struct record {
+    stamp file;
+    string_view value;
+  };
+
+ public:
+  file_cache(const std::string& path, std::uint64_t version) : path_{path}, version_{version}, file_{path} {
+    string_view in{file_.data(), file_.size()};
+    char magic[8] = {};
+    std::uint64_t file_version{};
+    if (not deserialize(in, magic) || std::memcmp(magic, MAGIC(), sizeof(magic)) || not deserialize(in, file_version) ||
+        file_version != version_) {
+      rewrite_ = true;
+      return;
+    }
+
+    std::size_t stale{};
+    for (;;) {
+      std::uint64_t size{}, checksum{};
+      if (not deserialize(in, size) || not deserialize(in, checksum) || in.size() < size ||
+          hash(in.data(), size) != checksum) {
+        break;  // truncated by an interrupted write
+      }
+      auto data = in.substr(0, size);
+      in = in.substr(size);
+
+      std::string name{};
+      record r{};
+      if (deserialize(data, name) && deserialize(data, r.file)) {
+        r.value = data;
+        const auto it = records_.find(name);
+        if (it != records_.end()) {
+          stale += it->second.value.size();
+        }
+        records_[name] = r;
+      }
+    }
+    rewrite_ = not in.empty() || stale * 2 > file_.size();
+  }
+
+  file_cache(const file_cache&) = delete;
+  file_cache& operator=(const file_cache&) = delete;
+
+  /**
+   * @return cached value or a view with nullptr data if the file has changed
+   *
+   * A file with a new mtime but the same content keeps its value, the new stamp is saved so that it isn't hashed again.
+   */
+  string_view get(const std::string& name) const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto value = values_.find(name);
+    if (value != values_.end()) {
+      return string_view{value->second}.substr(sizeof(stamp));
+    }
+    const auto it = records_.find(name);
+    if (it == records_.end()) {
+      return {};
+    }
+    const auto s = make_stamp(name, false);
+    if (s.size != it->second.file.size) {
+      return {};
+    }
+    if (s.mtime == it->second.file.mtime) {
+      return it->second.value;
+    }
+    const auto touched = make_stamp(name, true);
+    if (touched.hash != it->second.file.hash) {
+      return {};
+    }
+    std::string data{};
+    serialize(data, touched);
+    data.append(it->second.value.data(), it->second.value.size());
+    auto& refreshed = values_[name] = std::move(data);
+    unsaved_.push_back(name);
+    return string_view{refreshed}.substr(sizeof(stamp));
+  }
+
+  void put(const std::string& name, const std::string& value) {
+    std::string data{};
+    serialize(data, make_stamp(name, true));
+    data += value;
+    std::lock_guard<std::mutex> lock{mutex_};
+    values_[name] = std::move(data);
+    unsaved_.push_back(name);
+  }
+
+  void save() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (unsaved_.empty()) {
+      return;
+    }
+    const auto dir = path_.find_last_of('/');
+    if (dir != std::string::npos) {
+      ::mkdir(path_.substr(0, dir).c_str(), 0755);
+    }
+
+    std::string out{};
+    if (rewrite_) {
+      out.append(MAGIC(), 8);
+      serialize(out, version_);
+      for (const auto& r : records_) {
+        if (not values_.count(r.first)) {
+          std::string data{};
+          serialize(data, r.second.file);
+          data.append(r.second.value.data(), r.second.value.size());
+          append(out, r.first, data);
+        }
+      }
+      for (const auto& value : values_) {
+        append(out, value.first, value.second);
+      }
+    } else {
+      for (const auto& name : unsaved_) {
+        append(out, name, values_.at(name));
+      }
+    }
+    unsaved_.clear();
+
+    const auto tmp = path_ + ".tmp";
+    const auto name = rewrite_ ? tmp : path_;
+    std::unique_ptr<FILE, decltype(&std::fclose)> file{std::fopen(name.c_str(), rewrite_ ? "wb" : "ab"), &std::fclose};
+    if (file && std::fwrite(out.data(), 1, out.size(), file.get()) == out.size() && rewrite_) {
+      file.reset();
+      rewrite_ = std::rename(tmp.c_str(), path_.c_str()) != 0;
+    }
+  }
+
+ private:
+  static const char* MAGIC() { return "GUNITFC"; }
+
+  static void append(std::string& out, const std::string& name, const std::string& data) {
+    std::string r{};
+    serialize(r, name);
+    r += data;
+    serialize(out, std::uint64_t(r.size()));
+    serialize(out, hash(r));
+    out += r;
+  }
+
+  static stamp make_stamp(const std::string& name, bool content) {
+    struct stat st {};
+    if (::stat(name.c_str(), &st)) {
+      return {};
+    }
+#if defined(__APPLE__)
+    const auto mtime = std::uint64_t(st.st_mtimespec.tv_sec) * 1000000000ull + st.st_mtimespec.tv_nsec;
+#else
+    const auto mtime = std::uint64_t(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec;
+#endif
+    if (not content) {
+      return {std::uint64_t(st.st_size), mtime, 0};
+    }
+    const mapped_file file{name};
+    return {std::uint64_t(st.st_size), mtime, hash(file.data(), file.size())};
+  }
+
+  std::string path_{};
+  std::uint64_t version_{};
+  mapped_file file_;
+  std::unordered_map<std::string, record> records_{};
+  mutable std::unordered_map<std::string, std::string> values_{};  // put or refreshed by get
+  mutable std::vector<std::string> unsaved_{};
+  bool rewrite_{};
+  mutable std::mutex mutex_{};
+};
+
+/**
+ * Hash of the test body machine code and of the content of `--gunit_cache_inputs=file1:file2`, 0 if unknown
+ *
+ * Only the bytes of the body itself are hashed, changes of the functions it calls (the code under test) aren't
+ * noticed unless their binaries are listed in the inputs.
+ */
+inline std::uint64_t fingerprint(const void* code) {
+  static const auto inputs = [] {
+    auto seed = hash(std::string{});
+    for (const auto& input : split(GetFlag("cache_inputs"), ':')) {
+      const mapped_file file{input};
+      seed = hash(file.data(), file.size(), hash(input, seed));
+    }
+    return seed;
+  }();
+  const auto size = function_size(code);
+  return size ? hash(static_cast<const char*>(code), size, inputs) : 0;
+}
+
+/**
+ * Cache of test results enabled by `--gunit_cached`, only passed tests are skipped
+ *
+ * A test stays cached when only the code it calls changes, see fingerprint.
+ */
+class results_cache {
+  class listener : public EmptyTestEventListener {
+    void OnTestEnd(const TestInfo& info) override {
+      auto& tracked = instance()->tracked_;
+      const auto it = tracked.find(name(std::string{info.test_case_name()} + "." + info.name()));
+      if (it != tracked.end()) {
+        instance()->cache_.update(it->first, it->second, info.result()->Passed());
+      }
+    }
+
+    void OnTestProgramEnd(const UnitTest&) override { instance()->cache_.save(); }
+  };
+
+  struct cached_test : Test {
+    void TestBody() override { GetReporter().OnShould("CACHED", "passed", false); }
+  };
+
+ public:
+  static results_cache* instance() {
+    static const std::unique_ptr<results_cache> cache{GetBoolFlag("cached") ? new results_cache{} : nullptr};
+    return cache.get();
+  }
+
+  template <class T>
+  internal::TestFactoryBase* make_factory(const std::string& test, const void* code) {
+    const auto fp = fingerprint(code);
+    if (fp) {
+      tracked_[name(test)] = fp;
+      if (cache_.passed(name(test), fp)) {
+        return new internal::TestFactoryImpl<cached_test>{};
+      }
+    }
+    return new internal::TestFactoryImpl<T>{};
+  }
+
+ private:
+  results_cache() { UnitTest::GetInstance()->listeners().Append(new listener{}); }
+
+  /**
+   * SHOULDs might be filtered out, hence results are cached per SHOULD filter
+   */
+  static std::string name(const std::string& test) {
+    const std::string filter = GTEST_FLAG(filter);
+    const auto should = filter.find(':');
+    return test + (should != std::string::npos ? filter.substr(should) : std::string{});
+  }
+
+  test_cache cache_{".gunit-cache/" + basename(progname())};
+  std::unordered_map<std::string, std::uint64_t> tracked_{};
+};
+
+/**
+ * @return factory of the test or of its cached result when `--gunit_cached` is set
+ */
+template <class T>
+inline internal::TestFactoryBase* make_test_factory(const std::string& test, const void* code) {
+  const auto cache = results_cache::instance();
+  return cache ? cache->make_factory<T>(test, code) : new internal::TestFactoryImpl<T>{};
+}
+
+}  // detail
+}  // v1
+}  // testing
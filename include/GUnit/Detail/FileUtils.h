@@ -7,9 +7,18 @@
 //
 #pragma once
 
-#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include "GUnit/Detail/StringUtils.h"
 
 namespace testing {
 inline namespace v1 {
@@ -17,12 +26,106 @@ namespace detail {
 
 inline auto basename(const std::string &path) { return path.substr(path.find_last_of("/\\") + 1); }
 
+/**
+ * Read-only memory mapping of a file, empty when the file doesn't exist
+ */
+class mapped_file {
+ public:
+  explicit mapped_file(const std::string &path) {
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    open_ = true;
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      const auto data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const char *>(data);
+        size_ = st.st_size;
+      }
+    }
+    ::close(fd);
+  }
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  ~mapped_file() {
+    if (data_) {
+      ::munmap(const_cast<char *>(data_), size_);
+    }
+  }
+
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return not size_; }
+  bool is_open() const { return open_; }
+
+ private:
+  const char *data_{};
+  std::size_t size_{};
+  bool open_{};
+};
+
 inline std::wstring read_file(const std::string &feature) {
-  std::ifstream file{feature};
-  if (!file.good()) {
+  const mapped_file file{feature};
+  if (not file.is_open()) {
     throw std::runtime_error("File \"" + feature + "\" not found!");
   }
-  return {(std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()};
+  return utf8_decode(file.data(), file.size());
+}
+
+/**
+ * @return modification time of the file in nanoseconds, 0 when the file doesn't exist
+ */
+inline std::uint64_t modification_time(const std::string &path) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st)) {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return std::uint64_t(st.st_mtimespec.tv_sec) * 1000000000ull + st.st_mtimespec.tv_nsec;
+#else
+  return std::uint64_t(st.st_mtim.tv_sec) * 1000000000ull + st.st_mtim.tv_nsec;
+#endif
+}
+
+inline bool is_directory(const std::string &path) {
+  struct stat st {};
+  return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+struct directory_entries {
+  std::vector<std::string> files{};
+  std::vector<std::string> directories{};
+};
+
+/**
+ * @return sorted names of the files and of the subdirectories, hidden entries and links to directories are skipped
+ */
+inline directory_entries read_directory(const std::string &path) {
+  directory_entries entries{};
+  std::unique_ptr<DIR, int (*)(DIR *)> dir{::opendir(path.c_str()), &::closedir};
+  if (not dir) {
+    return entries;
+  }
+  while (const auto entry = ::readdir(dir.get())) {
+    const std::string name = entry->d_name;
+    if (name.empty() || name[0] == '.') {
+      continue;
+    }
+    auto directory = entry->d_type == DT_DIR;
+    if (entry->d_type == DT_UNKNOWN) {
+      directory = is_directory(path + '/' + name);
+    } else if (entry->d_type == DT_LNK && is_directory(path + '/' + name)) {
+      continue;
+    }
+    (directory ? entries.directories : entries.files).push_back(name);
+  }
+  std::sort(entries.files.begin(), entries.files.end());
+  std::sort(entries.directories.begin(), entries.directories.end());
+  return entries;
 }
 
 }  // detail
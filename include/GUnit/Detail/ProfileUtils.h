@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "GUnit/Detail/ReportUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Log-linear histogram of durations in nanoseconds, 8 buckets per power of two (percentiles are within 12.5%)
+ *
+ * Buckets are allocated up to the longest duration, so the memory doesn't grow with the number of samples.
+ */
+class duration_histogram {
+  static constexpr auto SUB_BUCKETS = 8u;
+  static constexpr auto SUB_BITS = 3u;
+
+ public:
+  void add(std::uint64_t duration) {
+    const auto i = index(duration);
+    if (i >= buckets_.size()) {
+      buckets_.resize(i + 1);
+    }
+    ++buckets_[i];
+    max_ = std::max(max_, duration);
+  }
+
+  void merge(const duration_histogram& other) {
+    if (other.buckets_.size() > buckets_.size()) {
+      buckets_.resize(other.buckets_.size());
+    }
+    for (auto i = 0u; i < other.buckets_.size(); ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+    max_ = std::max(max_, other.max_);
+  }
+
+  /**
+   * @return upper bound of the bucket containing the percentile (0, 100], not more than the longest duration
+   */
+  std::uint64_t percentile(double p) const {
+    std::uint64_t count{};
+    for (const auto bucket : buckets_) {
+      count += bucket;
+    }
+    const auto rank = std::max(std::uint64_t(1), std::uint64_t(count * p / 100 + 0.5));
+    std::uint64_t seen{};
+    for (auto i = 0u; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        return std::min(upper_bound(i), max_);
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static std::size_t index(std::uint64_t duration) {
+    if (duration < SUB_BUCKETS) {
+      return duration;
+    }
+    auto exponent = 0u;
+    while (duration >> (exponent + 1)) {
+      ++exponent;
+    }
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + ((duration >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+  }
+
+  static std::uint64_t upper_bound(std::size_t i) {
+    if (i < SUB_BUCKETS) {
+      return i;
+    }
+    const auto shift = i / SUB_BUCKETS - 1;
+    return ((SUB_BUCKETS + i % SUB_BUCKETS + 1) << shift) - 1;
+  }
+
+  std::vector<std::uint64_t> buckets_{};
+  std::uint64_t max_{};
+};
+
+/**
+ * Durations of the calls of a step definition
+ */
+struct step_profile {
+  std::string keyword{};
+  std::string pattern{};
+  std::string file{};
+  int line{};
+  std::uint64_t calls{};
+  std::uint64_t total{};
+  std::uint64_t hooks{};  // time spent in Before/After around the step
+  duration_histogram durations{};
+};
+
+/**
+ * Aggregates durations of step definitions, every thread records into its own shard which is merged on report
+ */
+class step_profiler {
+  using key_t = std::tuple<std::string, std::string, std::string, int>;  // keyword, pattern, file, line
+  using shard_t = std::map<key_t, step_profile, std::less<>>;
+
+ public:
+  void record(const std::string& keyword, const std::string& pattern, const std::string& file, int line,
+              std::uint64_t duration, std::uint64_t hooks) {
+    auto& shard = this->shard();
+    auto it = shard.find(std::tie(keyword, pattern, file, line));
+    if (it == shard.end()) {
+      it = shard.emplace(key_t{keyword, pattern, file, line}, step_profile{keyword, pattern, file, line, {}, {}, {}, {}})
+               .first;
+    }
+    auto& profile = it->second;
+    ++profile.calls;
+    profile.total += duration;
+    profile.hooks += hooks;
+    profile.durations.add(duration);
+  }
+
+  /**
+   * @return profiles of the step definitions sorted by the total duration, the longest first
+   */
+  std::vector<step_profile> profiles() const {
+    shard_t merged{};
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      for (const auto& shard : shards_) {
+        for (const auto& p : *shard) {
+          auto it = merged.find(p.first);
+          if (it == merged.end()) {
+            merged.emplace(p);
+          } else {
+            it->second.calls += p.second.calls;
+            it->second.total += p.second.total;
+            it->second.hooks += p.second.hooks;
+            it->second.durations.merge(p.second.durations);
+          }
+        }
+      }
+    }
+    std::vector<step_profile> result{};
+    for (auto& p : merged) {
+      result.push_back(std::move(p.second));
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [](const step_profile& lhs, const step_profile& rhs) { return lhs.total > rhs.total; });
+    return result;
+  }
+
+ private:
+  shard_t& shard() {
+    static thread_local std::map<std::uint64_t, shard_t*> shards{};
+    auto& shard = shards[id_];
+    if (not shard) {
+      std::lock_guard<std::mutex> lock{mutex_};
+      shards_.push_back(std::make_unique<shard_t>());
+      shard = shards_.back().get();
+    }
+    return *shard;
+  }
+
+  static std::uint64_t next_id() {
+    static std::atomic<std::uint64_t> id{};
+    return id++;
+  }
+
+  std::uint64_t id_{next_id()};  // unlike the address, not reused by the following profilers
+  mutable std::mutex mutex_{};
+  std::vector<std::unique_ptr<shard_t>> shards_{};  // outlive the threads
+};
+
+/**
+ * @return duration formatted with the unit (ns, us, ms, s), 3 decimals above nanoseconds
+ */
+inline std::string format_duration(std::uint64_t duration) {
+  const char* units[] = {"ns", "us", "ms", "s"};
+  auto unit = 0u;
+  auto scale = 1.0;
+  while (unit < 3 && duration >= scale * 1000) {
+    scale *= 1000;
+    ++unit;
+  }
+  char buffer[32] = {};
+  std::snprintf(buffer, sizeof(buffer), unit ? "%.3f %s" : "%.0f %s", duration / scale, units[unit]);
+  return buffer;
+}
+
+/**
+ * Table of the profiles, one line per step definition
+ */
+inline std::string format_profiles(const std::vector<step_profile>& profiles) {
+  std::string out{};
+  const auto row = [&out](const std::string& calls, const std::string& total, const std::string& mean,
+                          const std::string& p99, const std::string& hooks, const std::string& step) {
+    out += "[ PROFILE  ] ";
+    append(out, calls, 10, false);
+    append(out, total, 14, false);
+    append(out, mean, 14, false);
+    append(out, p99, 14, false);
+    append(out, hooks, 14, false);
+    out += "  ";
+    out += step;
+    out += '\n';
+  };
+
+  row("calls", "total", "mean", "p99", "hooks", "step");
+  for (const auto& p : profiles) {
+    row(std::to_string(p.calls), format_duration(p.total), format_duration(p.calls ? p.total / p.calls : 0),
+        format_duration(p.durations.percentile(99)), format_duration(p.hooks),
+        p.keyword + ' ' + p.pattern +
+            (p.file.empty() ? std::string{} : " # " + p.file + (p.line ? ':' + std::to_string(p.line) : std::string{})));
+  }
+  return out;
+}
+
+/**
+ * JSON array of the profiles, durations in nanoseconds
+ */
+inline std::string profiles_to_json(const std::vector<step_profile>& profiles) {
+  std::string out{"["};
+  for (const auto& p : profiles) {
+    if (out.size() > 1) {
+      out += ',';
+    }
+    out += "\n  {\"keyword\":";
+    append_json(out, p.keyword);
+    out += ",\"pattern\":";
+    append_json(out, p.pattern);
+    out += ",\"file\":";
+    append_json(out, p.file);
+    out += ",\"line\":" + std::to_string(p.line);
+    out += ",\"calls\":" + std::to_string(p.calls);
+    out += ",\"total\":" + std::to_string(p.total);
+    out += ",\"mean\":" + std::to_string(p.calls ? p.total / p.calls : 0);
+    out += ",\"p99\":" + std::to_string(p.durations.percentile(99));
+    out += ",\"max\":" + std::to_string(p.durations.percentile(100));
+    out += ",\"hooks\":" + std::to_string(p.hooks) + '}';
+  }
+  out += "\n]\n";
+  return out;
+}
+
+/**
+ * Measures consecutive intervals
+ */
+class stopwatch {
+ public:
+  /**
+   * @return nanoseconds since the previous lap (or the construction)
+   */
+  std::uint64_t lap() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count();
+    last_ = now;
+    return elapsed;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point last_{std::chrono::steady_clock::now()};
+};
+
+}  // detail
+}  // v1
+}  // testing
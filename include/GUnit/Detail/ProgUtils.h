@@ -9,13 +9,27 @@
 
 #include <cxxabi.h>
 #include <execinfo.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include "GUnit/Detail/FileUtils.h"
 #include "gtest/gtest.h"
 
 #if defined(__APPLE__)
 #include <libproc.h>
 #elif defined(__linux__)
+#include <link.h>
 extern const char *__progname_full;
 #endif
 
@@ -46,10 +60,10 @@ inline auto &progname() {
   return self;
 }
 
-inline std::string call_stack(const std::string &newline, int stack_begin = 1, int stack_size = GUNIT_SHOW_STACK_SIZE) {
-  static constexpr auto MAX_CALL_STACK_SIZE = 64;
-  void *bt[MAX_CALL_STACK_SIZE];
-  const auto frames = backtrace(bt, sizeof(bt) / sizeof(bt[0]));
+/**
+ * @return symbolized frames captured by backtrace
+ */
+inline std::string call_stack(void *const *bt, int frames, const std::string &newline, int stack_begin, int stack_size) {
   const auto symbols = backtrace_symbols(bt, frames);
   std::shared_ptr<char *> free{symbols, std::free};
   std::stringstream result;
@@ -76,6 +90,13 @@ inline std::string call_stack(const std::string &newline, int stack_begin = 1, i
   return result.str();
 }
 
+inline std::string call_stack(const std::string &newline, int stack_begin = 1, int stack_size = GUNIT_SHOW_STACK_SIZE) {
+  static constexpr auto MAX_CALL_STACK_SIZE = 64;
+  void *bt[MAX_CALL_STACK_SIZE];
+  const auto frames = backtrace(bt, sizeof(bt) / sizeof(bt[0]));
+  return call_stack(bt, frames, newline, stack_begin, stack_size);
+}
+
 inline std::pair<std::string, int> addr2line(void *addr) {
   std::stringstream cmd;
   cmd << "addr2line -Cpe " << progname() << " " << addr;
@@ -99,6 +120,154 @@ inline std::pair<std::string, int> addr2line(void *addr) {
   return {res2.substr(0, colon), std::atoi(res2.substr(colon + 1).c_str())};
 }
 
+/**
+ * @return size of the function's machine code taken from the program's symbol table, 0 if unknown
+ */
+inline std::size_t function_size(const void *addr) {
+#if defined(__linux__)
+  static const auto sizes = [] {
+    std::unordered_map<std::uintptr_t, std::size_t> sizes{};
+    std::uintptr_t bias{};
+    dl_iterate_phdr(
+        [](dl_phdr_info *info, std::size_t, void *bias) {
+          *static_cast<std::uintptr_t *>(bias) = info->dlpi_addr;
+          return 1;  // the first object is the program itself
+        },
+        &bias);
+
+    const mapped_file exe{"/proc/self/exe"};
+    const auto ehdr = reinterpret_cast<const ElfW(Ehdr) *>(exe.data());
+    if (exe.size() < sizeof(ElfW(Ehdr)) || std::memcmp(ehdr->e_ident, ELFMAG, SELFMAG) ||
+        exe.size() < ehdr->e_shoff + ehdr->e_shnum * sizeof(ElfW(Shdr))) {
+      return sizes;
+    }
+    const auto shdrs = reinterpret_cast<const ElfW(Shdr) *>(exe.data() + ehdr->e_shoff);
+    for (auto i = 0u; i < ehdr->e_shnum; ++i) {
+      if ((shdrs[i].sh_type != SHT_SYMTAB && shdrs[i].sh_type != SHT_DYNSYM) || not shdrs[i].sh_entsize ||
+          exe.size() < shdrs[i].sh_offset + shdrs[i].sh_size) {
+        continue;
+      }
+      const auto syms = reinterpret_cast<const ElfW(Sym) *>(exe.data() + shdrs[i].sh_offset);
+      for (auto j = 0u; j < shdrs[i].sh_size / shdrs[i].sh_entsize; ++j) {
+        if (ELF64_ST_TYPE(syms[j].st_info) == STT_FUNC && syms[j].st_value && syms[j].st_size) {
+          sizes[bias + syms[j].st_value] = syms[j].st_size;
+        }
+      }
+    }
+    return sizes;
+  }();
+
+  const auto it = sizes.find(reinterpret_cast<std::uintptr_t>(addr));
+  return it != sizes.end() ? it->second : 0;
+#else
+  (void)addr;
+  return 0;
+#endif
+}
+
+struct forked_result {
+  bool exited{};         // normally
+  std::string out{};     // written so far when the child didn't exit normally
+  std::string status{};  // description of how the child exited
+};
+
+/**
+ * Calls expr(write) in a forked child, everything written by the child is sent back to the parent through a pipe
+ *
+ * forked(pid) is called in the parent before it starts waiting for the child.
+ */
+template <class TExpr, class TForked>
+inline forked_result run_forked(const TExpr &expr, const TForked &forked) {
+  int fds[2] = {};
+  if (pipe(fds)) {
+    throw std::runtime_error{"pipe: " + std::string{std::strerror(errno)}};
+  }
+  std::fflush(nullptr);
+  const auto pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    throw std::runtime_error{"fork: " + std::string{std::strerror(errno)}};
+  }
+
+  if (not pid) {
+    close(fds[0]);
+    const auto write_all = [&](const std::string &out) {
+      for (std::size_t written = 0; written < out.size();) {
+        const auto size = write(fds[1], out.data() + written, out.size() - written);
+        if (size < 0 && errno != EINTR) {
+          _exit(1);
+        }
+        written += size > 0 ? std::size_t(size) : 0;
+      }
+    };
+    auto code = 0;
+    try {
+      expr(write_all);
+    } catch (...) {
+      code = 1;
+    }
+    std::fflush(nullptr);  // _exit doesn't flush stdio
+    _exit(code);
+  }
+
+  close(fds[1]);
+  forked(pid);
+  std::string out{};
+  char buffer[4096];
+  for (;;) {
+    const auto size = read(fds[0], buffer, sizeof(buffer));
+    if (size > 0) {
+      out.append(buffer, std::size_t(size));
+    } else if (not size || errno != EINTR) {
+      break;
+    }
+  }
+  close(fds[0]);
+
+  auto code = 0;
+  while (waitpid(pid, &code, 0) < 0 && errno == EINTR) {
+  }
+  return {WIFEXITED(code) && not WEXITSTATUS(code), out,
+          WIFSIGNALED(code) ? "killed by signal " + std::to_string(WTERMSIG(code))
+                            : "exited with " + std::to_string(WEXITSTATUS(code))};
+}
+
+template <class TExpr>
+inline forked_result run_forked(const TExpr &expr) {
+  return run_forked(expr, [](pid_t) {});
+}
+
+/**
+ * @param bare_value returned for `--gunit_<name>` without a value, so that it differs from the value "1"
+ * @return value of `--gunit_<name>=value` or value of `GUNIT_<NAME>` environment variable
+ */
+inline std::string GetFlag(const std::string &name, const std::string &default_value = {},
+                           const std::string &bare_value = "1") {
+  const auto flag = "--gunit_" + name;
+  for (const auto &arg : internal::GetArgvs()) {
+    if (arg == flag) {
+      return bare_value;
+    }
+    if (arg.compare(0, flag.size() + 1, flag + "=") == 0) {
+      return arg.substr(flag.size() + 1);
+    }
+  }
+
+  auto env = "GUNIT_" + name;
+  std::transform(env.begin(), env.end(), env.begin(), [](char c) { return std::toupper(c); });
+  const auto value = std::getenv(env.c_str());
+  return value ? value : default_value;
+}
+
+/**
+ * @return whether `--gunit_<name>` (or `GUNIT_<NAME>`) is on, "0", "false" and an empty value turn it off
+ */
+inline bool GetBoolFlag(const std::string &name) {
+  const auto value = GetFlag(name);
+  return not value.empty() && value != "0" && value != "false";
+}
+
 }  // detail
 }  // v1
 }  // testing
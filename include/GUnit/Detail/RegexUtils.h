@@ -7,7 +7,13 @@
 //
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "GUnit/Detail/StringUtils.h"
@@ -20,7 +26,9 @@ template <class T>
 inline constexpr auto args_size(T str) {
   auto args = 0;
   for (auto i = 0u; i < str.size(); ++i) {
-    if (str[i] == '{') {
+    if (str[i] == '\\') {
+      ++i;
+    } else if (str[i] == '{') {
       ++args;
     }
   }
@@ -60,20 +68,598 @@ inline auto match(T pattern, const std::string& str) {
   return not matches(pattern, str).empty() || std::string{pattern.c_str()} == str;
 }
 
+struct pattern_part {
+  enum { literal, word, quoted } kind;
+  std::size_t begin;
+  std::size_t size;
+};
+
+template <std::size_t N>
+struct pattern_parts {
+  pattern_part parts[N];
+  std::size_t size;
+};
+
+/**
+ * Splits a compile-time pattern into literals, `{...}` words and `'{...}` quoted texts
+ */
+template <class TPattern>
+constexpr auto parse_pattern() {
+  TPattern pattern{};
+  pattern_parts<2 * args_size(TPattern{}) + 1> result{};
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] == '{' || (pattern[i] == '\'' && i + 1 < pattern.size() && pattern[i + 1] == '{')) {
+      result.parts[result.size++] = {pattern[i] == '{' ? pattern_part::word : pattern_part::quoted, i, 0};
+      while (i < pattern.size() && pattern[i] != '}') {
+        ++i;
+      }
+    } else if (result.size && result.parts[result.size - 1].kind == pattern_part::literal) {
+      ++result.parts[result.size - 1].size;
+    } else {
+      result.parts[result.size++] = {pattern_part::literal, i, 1};
+    }
+  }
+  return result;
+}
+
+/**
+ * Matcher generated for a `_step` pattern, literals are compared with memcmp and captures are views into the step
+ */
+template <class TPattern>
+class compiled_pattern {
+  static constexpr auto PARTS = parse_pattern<TPattern>().size;
+
+  template <std::size_t N>
+  using index = std::integral_constant<std::size_t, N>;
+
+ public:
+  using captures_t = std::array<string_view, args_size(TPattern{})>;
+
+  /**
+   * @return true when the whole step is matched
+   */
+  static bool match(string_view step, captures_t& captures) { return match(step, 0, captures, index<0>{}, index<0>{}); }
+
+ private:
+  template <std::size_t Part, std::size_t Capture>
+  static bool match(string_view step, std::size_t pos, captures_t& captures, index<Part>, index<Capture>) {
+    constexpr auto part = parse_pattern<TPattern>().parts[Part];
+    return match(step, pos, captures, index<Part>{}, index<Capture>{},
+                 std::integral_constant<bool, part.kind == pattern_part::literal>{});
+  }
+
+  template <std::size_t Part, std::size_t Capture>
+  static bool match(string_view step, std::size_t pos, captures_t& captures, index<Part>, index<Capture>,
+                    std::true_type /*literal*/) {
+    constexpr auto part = parse_pattern<TPattern>().parts[Part];
+    if (step.size() - pos < part.size || std::memcmp(step.data() + pos, TPattern::c_str() + part.begin, part.size)) {
+      return false;
+    }
+    return match(step, pos + part.size, captures, index<Part + 1>{}, index<Capture>{});
+  }
+
+  template <std::size_t Part, std::size_t Capture>
+  static bool match(string_view step, std::size_t pos, captures_t& captures, index<Part>, index<Capture>,
+                    std::false_type /*literal*/) {
+    constexpr auto quoted = parse_pattern<TPattern>().parts[Part].kind == pattern_part::quoted;
+    if (quoted && (pos == step.size() || step[pos] != '\'')) {
+      return false;
+    }
+    const auto begin = pos + quoted;
+    auto end = begin;
+    while (end < step.size() && step[end] != (quoted ? '\'' : ' ')) {
+      ++end;
+    }
+    std::get<Capture>(captures) = step.substr(begin, end - begin);
+    return match(step, end, captures, index<Part + 1>{}, index<Capture + 1>{});
+  }
+
+  template <std::size_t Capture>
+  static bool match(string_view step, std::size_t pos, captures_t&, index<PARTS>, index<Capture>) {
+    return pos == step.size();
+  }
+};
+
+/**
+ * @return end of the integer (`[-+]?[0-9]+`) at pos, npos when there is none
+ */
+inline std::size_t scan_int(string_view str, std::size_t pos) {
+  auto i = pos + (pos < str.size() && (str[pos] == '-' || str[pos] == '+'));
+  const auto digits = i;
+  while (i < str.size() && std::isdigit(static_cast<unsigned char>(str[i]))) {
+    ++i;
+  }
+  return i == digits ? string_view::npos : i;
+}
+
+/**
+ * @return end of the floating point number (`[-+]?[0-9]*(\.[0-9]+)?([eE][-+]?[0-9]+)?`, at least one digit) at pos,
+ *         npos when there is none
+ */
+inline std::size_t scan_float(string_view str, std::size_t pos) {
+  const auto digit = [&str](std::size_t i) { return i < str.size() && std::isdigit(static_cast<unsigned char>(str[i])); };
+  auto i = pos + (pos < str.size() && (str[pos] == '-' || str[pos] == '+'));
+  const auto first = i;
+  while (digit(i)) {
+    ++i;
+  }
+  if (i < str.size() && str[i] == '.' && digit(i + 1)) {
+    i += 2;
+    while (digit(i)) {
+      ++i;
+    }
+  }
+  if (i == first) {
+    return string_view::npos;
+  }
+  if (i < str.size() && (str[i] == 'e' || str[i] == 'E')) {
+    const auto exponent = scan_int(str, i + 1);
+    if (exponent != string_view::npos) {
+      i = exponent;
+    }
+  }
+  return i;
+}
+
+/**
+ * @return end of the word (non-space characters) at pos, npos when there is none
+ */
+inline std::size_t scan_word(string_view str, std::size_t pos) {
+  auto i = pos;
+  while (i < str.size() && not std::isspace(static_cast<unsigned char>(str[i]))) {
+    ++i;
+  }
+  return i == pos ? string_view::npos : i;
+}
+
+/**
+ * @return end of the text quoted with " or ' (after the closing quote) at pos, npos when there is none
+ */
+inline std::size_t scan_string(string_view str, std::size_t pos) {
+  if (pos >= str.size() || (str[pos] != '"' && str[pos] != '\'')) {
+    return string_view::npos;
+  }
+  const auto close = std::find(str.begin() + pos + 1, str.end(), str[pos]);
+  return close == str.end() ? string_view::npos : std::size_t(close - str.begin()) + 1;
+}
+
+/**
+ * Cucumber expression (`I have {int} cucumber(s) in my belly/stomach`) compiled into text and parameter parts
+ *
+ * Parameters are `{int}`, `{float}`, `{word}`, `{string}` (quoted with " or ', captured without the quotes) and `{}`
+ * (anything). Text in parentheses is optional, alternatives of a word are separated with '/', '\\' escapes.
+ * Texts are expanded into all of their alternatives when compiled, matching only compares them and scans parameters.
+ */
+class cucumber_expression {
+ public:
+  enum class parameter { none, integer, number, word, string, any };
+
+  struct part {
+    parameter type{};
+    std::vector<std::string> alternatives{};  // of a text part, longer alternatives of an optional text first
+  };
+
+  /**
+   * @throws std::invalid_argument for unknown parameter types and unbalanced braces or parentheses
+   */
+  explicit cucumber_expression(const std::string& expression) {
+    std::string text{};
+    for (auto i = 0u; i < expression.size(); ++i) {
+      if (expression[i] == '\\' && i + 1 < expression.size()) {
+        text += expression[i++];
+        text += expression[i];
+      } else if (expression[i] == '{') {
+        const auto end = expression.find('}', i);
+        if (end == std::string::npos) {
+          throw std::invalid_argument{"Unbalanced '{' in \"" + expression + "\""};
+        }
+        add_text(text, expression);
+        text.clear();
+        parts_.push_back({type(expression.substr(i + 1, end - i - 1), expression), {}});
+        ++parameters_;
+        i = end;
+      } else {
+        text += expression[i];
+      }
+    }
+    add_text(text, expression);
+  }
+
+  const std::vector<part>& parts() const { return parts_; }
+  std::size_t parameters() const { return parameters_; }
+
+  /**
+   * @param captures of the parameters, `parameters()` views into the step are written
+   * @return true when the whole step is matched
+   */
+  bool match(string_view step, string_view* captures) const { return match(step, 0, 0, captures); }
+
+ private:
+  static parameter type(const std::string& name, const std::string& expression) {
+    if (name == "int") {
+      return parameter::integer;
+    } else if (name == "float") {
+      return parameter::number;
+    } else if (name == "word") {
+      return parameter::word;
+    } else if (name == "string") {
+      return parameter::string;
+    } else if (name.empty()) {
+      return parameter::any;
+    }
+    throw std::invalid_argument{"Unknown parameter type {" + name + "} in \"" + expression + "\""};
+  }
+
+  static std::size_t find(const std::string& text, char c, std::size_t pos = 0) {
+    for (auto i = pos; i < text.size(); ++i) {
+      if (text[i] == '\\') {
+        ++i;
+      } else if (text[i] == c) {
+        return i;
+      }
+    }
+    return std::string::npos;
+  }
+
+  static std::vector<std::string> optionals(const std::string& text, const std::string& expression) {
+    const auto open = find(text, '(');
+    if (open == std::string::npos) {
+      return {text};
+    }
+    const auto close = find(text, ')', open);
+    if (close == std::string::npos) {
+      throw std::invalid_argument{"Unbalanced '(' in \"" + expression + "\""};
+    }
+    std::vector<std::string> result{};
+    for (const auto& rest : optionals(text.substr(close + 1), expression)) {
+      result.push_back(text.substr(0, open) + text.substr(open + 1, close - open - 1) + rest);
+      result.push_back(text.substr(0, open) + rest);
+    }
+    return result;
+  }
+
+  static std::vector<std::string> alternatives(const std::string& word) {
+    std::vector<std::string> result{};
+    for (std::size_t begin = 0, end = 0; end != std::string::npos; begin = end + 1) {
+      end = find(word, '/', begin);
+      result.push_back(word.substr(begin, end - begin));
+    }
+    return result;
+  }
+
+  /**
+   * Optionals may contain spaces, hence they are expanded over the whole text before it's split into words
+   */
+  void add_text(const std::string& text, const std::string& expression) {
+    if (text.empty()) {
+      return;
+    }
+    std::vector<std::string> result{};
+    for (const auto& expanded : optionals(text, expression)) {
+      std::vector<std::string> words{""};
+      for (std::size_t i = 0; i < expanded.size();) {
+        const auto space = std::isspace(static_cast<unsigned char>(expanded[i])) != 0;
+        auto end = i;
+        while (end < expanded.size() && (std::isspace(static_cast<unsigned char>(expanded[end])) != 0) == space) {
+          end += expanded[end] == '\\' ? 2 : 1;
+        }
+        end = std::min(end, expanded.size());
+        const auto token = expanded.substr(i, end - i);
+        const auto options = space ? std::vector<std::string>{token} : alternatives(token);
+        std::vector<std::string> next{};
+        for (const auto& prefix : words) {
+          for (const auto& option : options) {
+            next.push_back(prefix + option);
+          }
+        }
+        words = std::move(next);
+        i = end;
+      }
+      for (auto& word : words) {
+        result.push_back(std::move(word));
+      }
+    }
+    for (auto& alternative : result) {
+      std::string unescaped{};
+      for (auto i = 0u; i < alternative.size(); ++i) {
+        i += alternative[i] == '\\' && i + 1 < alternative.size();
+        unescaped += alternative[i];
+      }
+      alternative = std::move(unescaped);
+    }
+    parts_.push_back({parameter::none, std::move(result)});
+  }
+
+  bool match(string_view step, std::size_t pos, std::size_t part, string_view* captures) const {
+    if (part == parts_.size()) {
+      return pos == step.size();
+    }
+    const auto& p = parts_[part];
+    switch (p.type) {
+      case parameter::none:
+        for (const auto& alternative : p.alternatives) {
+          if (step.size() - pos >= alternative.size() &&
+              std::memcmp(step.data() + pos, alternative.data(), alternative.size()) == 0 &&
+              match(step, pos + alternative.size(), part + 1, captures)) {
+            return true;
+          }
+        }
+        return false;
+      case parameter::any:
+        for (auto end = step.size();; --end) {
+          *captures = step.substr(pos, end - pos);
+          if (match(step, end, part + 1, captures + 1)) {
+            return true;
+          }
+          if (end == pos) {
+            return false;
+          }
+        }
+      case parameter::string: {
+        const auto end = scan_string(step, pos);
+        if (end == string_view::npos) {
+          return false;
+        }
+        *captures = step.substr(pos + 1, end - pos - 2);
+        return match(step, end, part + 1, captures + 1);
+      }
+      default: {
+        const auto end = p.type == parameter::integer  ? scan_int(step, pos)
+                         : p.type == parameter::number ? scan_float(step, pos)
+                                                       : scan_word(step, pos);
+        if (end == string_view::npos) {
+          return false;
+        }
+        *captures = step.substr(pos, end - pos);
+        return match(step, end, part + 1, captures + 1);
+      }
+    }
+  }
+
+  std::vector<part> parts_{};
+  std::size_t parameters_{};
+};
+
+/**
+ * Step patterns compiled into a trie, walked once per step
+ *
+ * `{...}` is an edge capturing a word (up to a space) and `'{...}` an edge capturing a quoted text (up to a quote),
+ * whole step has to be matched. Cucumber expressions add alternative paths for their texts and edges scanning
+ * their parameters.
+ */
+class step_matcher {
+  static constexpr auto npos = std::size_t(-1);
+  using edges_t = std::vector<std::pair<char, std::size_t>>;
+
+  struct node {
+    edges_t next{};
+    std::size_t word = npos;
+    std::size_t quoted = npos;
+    std::size_t integer = npos;
+    std::size_t number = npos;
+    std::size_t string = npos;
+    std::size_t any = npos;
+    std::vector<std::size_t> ids{};
+  };
+
+  struct state {
+    std::size_t node;
+    std::size_t pos;
+    bool any;  // capturing `{}`, which may also end further
+  };
+
+ public:
+  void add(const std::string& pattern, std::size_t id) {
+    auto current = 0u;
+    for (auto i = 0u; i < pattern.size(); ++i) {
+      if (pattern[i] == '{' || (pattern[i] == '\'' && i + 1 < pattern.size() && pattern[i + 1] == '{')) {
+        const auto quoted = pattern[i] == '\'';
+        current = child(current, quoted ? &node::quoted : &node::word);
+        i = std::min(pattern.find('}', i), pattern.size());
+      } else {
+        current = child(current, pattern[i]);
+      }
+    }
+    nodes_[current].ids.push_back(id);
+  }
+
+  void add(const cucumber_expression& expression, std::size_t id) { add(expression, 0, 0, id); }
+
+  /**
+   * @return distinct ids of up to `max` patterns matching the step, valid until the next call on the same thread
+   */
+  const std::vector<std::size_t>& find(const std::string& step, std::size_t max = 2) const {
+    static thread_local std::vector<std::size_t> found_{};
+    static thread_local std::vector<state> states_{};
+    found_.clear();
+    states_.assign(1, {0, 0, false});
+    const auto push = [](std::size_t node, std::size_t pos) {
+      if (node != npos && pos != npos) {
+        states_.push_back({node, pos, false});
+      }
+    };
+    while (not states_.empty()) {
+      const auto s = states_.back();
+      states_.pop_back();
+      const auto& n = nodes_[s.node];
+      if (s.any && s.pos < step.size()) {
+        states_.push_back({s.node, s.pos + 1, true});  // one character further instead of every end at once
+      }
+      if (s.pos == step.size()) {
+        for (const auto id : n.ids) {
+          if (std::find(found_.begin(), found_.end(), id) != found_.end()) {
+            continue;  // reached by another path of its captures
+          }
+          found_.push_back(id);
+          if (found_.size() >= max) {
+            return found_;
+          }
+        }
+      }
+      if (n.word != npos) {
+        push(n.word, std::min(step.find(' ', s.pos), step.size()));
+      }
+      if (n.quoted != npos && s.pos < step.size() && step[s.pos] == '\'') {
+        push(n.quoted, std::min(step.find('\'', s.pos + 1), step.size()));
+      }
+      push(n.integer, scan_int(step, s.pos));
+      push(n.number, scan_float(step, s.pos));
+      push(n.string, scan_string(step, s.pos));
+      if (n.any != npos) {
+        states_.push_back({n.any, s.pos, true});
+      }
+      if (s.pos < step.size()) {
+        const auto it = lower_bound(n.next, step[s.pos]);
+        if (it != n.next.end() && it->first == step[s.pos]) {
+          push(it->second, s.pos + 1);
+        }
+      }
+    }
+    return found_;
+  }
+
+ private:
+  void add(const cucumber_expression& expression, std::size_t part, std::size_t current, std::size_t id) {
+    if (part == expression.parts().size()) {
+      auto& ids = nodes_[current].ids;
+      if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+        ids.push_back(id);
+      }
+      return;
+    }
+    using parameter = cucumber_expression::parameter;
+    const auto& p = expression.parts()[part];
+    switch (p.type) {
+      case parameter::none:
+        for (const auto& alternative : p.alternatives) {
+          auto next = current;
+          for (const auto c : alternative) {
+            next = child(next, c);
+          }
+          add(expression, part + 1, next, id);
+        }
+        break;
+      case parameter::integer:
+        add(expression, part + 1, child(current, &node::integer), id);
+        break;
+      case parameter::number:
+        add(expression, part + 1, child(current, &node::number), id);
+        break;
+      case parameter::word:
+        add(expression, part + 1, child(current, &node::word), id);
+        break;
+      case parameter::string:
+        add(expression, part + 1, child(current, &node::string), id);
+        break;
+      case parameter::any:
+        add(expression, part + 1, child(current, &node::any), id);
+        break;
+    }
+  }
+
+  static edges_t::const_iterator lower_bound(const edges_t& next, char c) {
+    return std::lower_bound(next.begin(), next.end(), c,
+                            [](const std::pair<char, std::size_t>& edge, char c) { return edge.first < c; });
+  }
+
+  std::size_t child(std::size_t current, std::size_t node::*edge) {
+    if (nodes_[current].*edge == npos) {
+      nodes_[current].*edge = nodes_.size();
+      nodes_.emplace_back();
+    }
+    return nodes_[current].*edge;
+  }
+
+  std::size_t child(std::size_t current, char c) {
+    const auto it = lower_bound(nodes_[current].next, c);
+    if (it != nodes_[current].next.end() && it->first == c) {
+      return it->second;
+    }
+    const auto next = nodes_.size();
+    nodes_[current].next.insert(it, {c, next});
+    nodes_.emplace_back();
+    return next;
+  }
+
+  std::vector<node> nodes_ = std::vector<node>(1);
+};
+
+// Two-pointer glob matcher, only the last '*' is ever backtracked to which keeps the matching linear in practice
+// and never exponential in the number of wildcards.
 inline bool PatternMatchesString(const char* pattern, const char* str) {
-  switch (*pattern) {
-    case '\0':
-    case ':':  // Either ':' or '\0' marks the end of the pattern.
-      return *str == '\0';
-    case '?':  // Matches any single character.
-      return *str != '\0' && PatternMatchesString(pattern + 1, str + 1);
-    case '*':  // Matches any string (possibly empty) of characters.
-      return (*str != '\0' && PatternMatchesString(pattern, str + 1)) || PatternMatchesString(pattern + 1, str);
-    default:  // Non-special character.  Matches itself.
-      return *pattern == *str && PatternMatchesString(pattern + 1, str + 1);
+  // Either ':' or '\0' marks the end of the pattern.
+  const auto is_end = [](const char* p) { return *p == '\0' || *p == ':'; };
+  const char* star = nullptr;
+  const char* backtrack = nullptr;
+
+  for (;;) {
+    if (*pattern == '*') {  // Matches any string (possibly empty) of characters.
+      star = ++pattern;
+      backtrack = str;
+    } else if (*str != '\0' && not is_end(pattern) && (*pattern == '?' || *pattern == *str)) {
+      ++pattern, ++str;
+    } else if (*str == '\0' && is_end(pattern)) {
+      return true;
+    } else if (star && *backtrack != '\0') {
+      pattern = star;
+      str = ++backtrack;
+    } else {
+      return false;
+    }
   }
 }
 
+/**
+ * Matches a path against a glob, `*` and `?` don't match '/' and a `**` segment matches any number of directories
+ */
+inline bool GlobMatchesPath(string_view glob, string_view path) {
+  const auto segment = [](string_view str) {
+    const auto slash = std::find(str.begin(), str.end(), '/');
+    return string_view{str.begin(), std::size_t(slash - str.begin())};
+  };
+  const auto rest = [](string_view str, string_view segment) {
+    return str.substr(std::min(segment.size() + 1, str.size()));
+  };
+  const auto matches = [](string_view pattern, string_view str) {
+    std::size_t p = 0, s = 0, star = string_view::npos, backtrack = 0;
+    while (s < str.size()) {
+      if (p < pattern.size() && pattern[p] == '*') {
+        star = ++p;
+        backtrack = s;
+      } else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+        ++p, ++s;
+      } else if (star != string_view::npos) {
+        p = star;
+        s = ++backtrack;
+      } else {
+        return false;
+      }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+      ++p;
+    }
+    return p == pattern.size();
+  };
+
+  if (glob.empty()) {
+    return path.empty();
+  }
+  const auto first = segment(glob);
+  if (first == "**") {
+    for (;;) {
+      if (GlobMatchesPath(rest(glob, first), path)) {
+        return true;
+      }
+      if (path.empty()) {
+        return false;
+      }
+      path = rest(path, segment(path));
+    }
+  }
+  const auto name = segment(path);
+  return not path.empty() && matches(first, name) && GlobMatchesPath(rest(glob, first), rest(path, name));
+}
+
 inline bool MatchesFilter(const std::string& name, const char* filter) {
   const char* cur_pattern = filter;
   for (;;) {
@@ -94,27 +680,129 @@ inline bool MatchesFilter(const std::string& name, const char* filter) {
   }
 }
 
-inline bool FilterMatchesShould(const std::string& name, const std::string& should) {
-  // Split --gtest_filter at '-', if there is one, to separate into
-  // positive filter and negative filter portions
-  const char* const p = should.c_str();
-  const char* const dash = strchr(p, '-');
-  std::string positive;
-  std::string negative;
-  if (dash == nullptr) {
-    positive = should.c_str();  // Whole string is a positive filter
-    negative = "";
-  } else {
-    positive = std::string(p, dash);   // Everything up to the dash
-    negative = std::string(dash + 1);  // Everything after the dash
-    if (positive.empty()) {
+/**
+ * --gtest_filter compiled once into positive/negative patterns
+ */
+class filter {
+  enum class kind { any, literal, glob };
+
+  struct pattern {
+    kind type{};
+    std::string value{};
+  };
+
+ public:
+  explicit filter(const std::string& flag = "*") {
+    // Split --gtest_filter at '-', if there is one, to separate into
+    // positive filter and negative filter portions
+    const auto dash = flag.find('-');
+    compile(flag.substr(0, dash), positive_);
+    if (dash != std::string::npos) {
+      compile(flag.substr(dash + 1), negative_);
+    }
+    if (positive_.empty()) {
       // Treat '-test1' as the same as '*-test1'
-      positive = "*";
+      positive_.push_back({kind::any, "*"});
     }
   }
 
-  return MatchesFilter(name, positive.c_str()) && !MatchesFilter(name, negative.c_str());
-}
+  bool matches(const std::string& name) const { return matches(positive_, name) && not matches(negative_, name); }
+
+  /**
+   * @return true if any name starting with `prefix` might match the positive patterns
+   */
+  bool matches_prefix(const std::string& prefix) const {
+    for (const auto& p : positive_) {
+      switch (p.type) {
+        case kind::any:
+          return true;
+        case kind::literal:
+          if (p.value.compare(0, prefix.size(), prefix) == 0) {
+            return true;
+          }
+          break;
+        case kind::glob:
+          if (PatternMatchesPrefix(p.value, prefix)) {
+            return true;
+          }
+          break;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static void compile(const std::string& patterns, std::vector<pattern>& result) {
+    for (const auto& value : split(patterns, ':')) {
+      if (value.empty()) {
+        continue;
+      }
+      if (value.find_first_not_of('*') == std::string::npos) {
+        result.push_back({kind::any, value});
+      } else if (value.find_first_of("*?") == std::string::npos) {
+        result.push_back({kind::literal, value});
+      } else {
+        result.push_back({kind::glob, value});
+      }
+    }
+  }
+
+  static bool PatternMatchesPrefix(const std::string& pattern, const std::string& prefix) {
+    std::vector<bool> states(pattern.size() + 1), next(pattern.size() + 1);
+    const auto closure = [&](std::vector<bool>& s) {
+      for (auto i = 0u; i < pattern.size(); ++i) {
+        if (s[i] && pattern[i] == '*') {
+          s[i + 1] = true;
+        }
+      }
+    };
+
+    states[0] = true;
+    closure(states);
+    for (const auto c : prefix) {
+      std::fill(next.begin(), next.end(), false);
+      auto alive = false;
+      for (auto i = 0u; i < pattern.size(); ++i) {
+        if (states[i] && pattern[i] == '*') {
+          alive = next[i] = true;
+        } else if (states[i] && (pattern[i] == '?' || pattern[i] == c)) {
+          alive = next[i + 1] = true;
+        }
+      }
+      if (not alive) {
+        return false;
+      }
+      closure(next);
+      states.swap(next);
+    }
+    return true;
+  }
+
+  static bool matches(const std::vector<pattern>& patterns, const std::string& name) {
+    for (const auto& p : patterns) {
+      switch (p.type) {
+        case kind::any:
+          return true;
+        case kind::literal:
+          if (p.value == name) {
+            return true;
+          }
+          break;
+        case kind::glob:
+          if (PatternMatchesString(p.value.c_str(), name.c_str())) {
+            return true;
+          }
+          break;
+      }
+    }
+    return false;
+  }
+
+  std::vector<pattern> positive_{};
+  std::vector<pattern> negative_{};
+};
+
+inline bool FilterMatchesShould(const std::string& name, const std::string& should) { return filter{should}.matches(name); }
 
 }  // detail
 }  // v1
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "GUnit/Detail/RegexUtils.h"
+#include "GUnit/Detail/ReportUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Compact static descriptor of tests, linked into an intrusive list during static initialization
+ */
+struct registration {
+  void (*make)(const filter&);
+  registration* next;
+};
+
+/**
+ * Materializes gtest TestInfo(s) only after --gtest_filter has been parsed
+ *
+ * gtest instantiates parameterized tests right after parsing the flags and before filtering the tests,
+ * which is the only hook available; the registry piggybacks on it with an empty sentinel instantiation.
+ */
+class lazy_registry {
+  struct sentinel : TestWithParam<int> {
+    void TestBody() override {}
+  };
+
+ public:
+  static void add(registration& r) {
+    static const auto installed = install();
+    (void)installed;
+    *last() = &r;
+    last() = &r.next;
+  }
+
+  static void materialize() {
+    reporter();  // report files (--gunit_report) have to be listening before the first test starts
+    const filter f{GTEST_FLAG(filter)};
+    for (auto r = first(); r; r = r->next) {
+      r->make(f);
+    }
+    first() = nullptr;
+    last() = &first();
+  }
+
+ private:
+  static registration*& first() {
+    static registration* first{};
+    return first;
+  }
+
+  static registration**& last() {
+    static registration** last = &first();
+    return last;
+  }
+
+  static internal::ParamGenerator<int> generate() {
+    materialize();
+    return ValuesIn(std::vector<int>{});
+  }
+
+  static std::string name(const TestParamInfo<int>&) { return {}; }
+
+  static bool install() {
+    auto holder = UnitTest::GetInstance()->parameterized_test_registry().GetTestCasePatternHolder<sentinel>(
+        "GUnit", {__FILE__, __LINE__});
+    holder->AddTestPattern("GUnit", "LazyRegistry", new internal::TestMetaFactory<sentinel>());
+    holder->AddTestCaseInstantiation("", &generate, &name, __FILE__, __LINE__);
+    return true;
+  }
+};
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,849 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "GUnit/Detail/ProgUtils.h"
+#include "GUnit/Detail/StringUtils.h"
+#include "GUnit/Detail/TermUtils.h"
+
+namespace testing {
+inline namespace v1 {
+
+/**
+ * Progress output of SHOULDs and scenario steps
+ */
+class Reporter {
+ public:
+  virtual ~Reporter() = default;
+  virtual void OnShould(const std::string& type, const std::string& name, bool disabled) = 0;
+  virtual void OnStep(const std::string& keyword, const std::string& text, const std::string& file, int line) = 0;
+  virtual void OnScenarioEnd() = 0;
+
+  /**
+   * Called before the steps of a scenario are run, tags include the inherited feature tags
+   */
+  virtual void OnScenario(const std::string& /*feature*/, const std::string& /*file*/, const std::string& /*name*/,
+                          int /*line*/, const std::vector<std::string>& /*tags*/) {}
+
+  /**
+   * Called after a step reported by OnStep when step results are reported (`--gunit_report`)
+   *
+   * @param status passed or failed
+   * @param duration in nanoseconds
+   * @param message of the failures, empty when the step has passed
+   */
+  virtual void OnStepEnd(const std::string& /*status*/, std::uint64_t /*duration*/, const std::string& /*message*/) {}
+
+  /**
+   * Called at the end of every test, output has to be written when it returns
+   */
+  virtual void Flush() = 0;
+};
+
+namespace detail {
+
+inline void append(std::string& buffer, const std::string& str, std::size_t width, bool left = true) {
+  const auto fill = str.size() < width ? width - str.size() : 0;
+  if (not left) {
+    buffer.append(fill, ' ');
+  }
+  buffer += str;
+  if (left) {
+    buffer.append(fill, ' ');
+  }
+}
+
+/**
+ * Formats into a buffer per reporter which is written in batches by a background thread
+ *
+ * Output shared with gtest and the tests (stdout, stderr) is written right away into the stdio buffer instead, so that
+ * it stays in order with the failures and the output of the tests.
+ *
+ * Flush stops the writer thread, the reporter has to be flushed before the process is forked (`--gunit_shared_prefix`),
+ * as only the forking thread survives in the child.
+ */
+class async_reporter : public Reporter {
+  static constexpr auto BATCH_SIZE = 64 * 1024;
+
+ public:
+  explicit async_reporter(FILE* out = stdout)
+      : out_{out},
+        colorize_{ShouldUseColor(internal::posix::IsATTY(internal::posix::FileNo(out)) != 0)},
+        shared_{out == stdout || out == stderr} {}
+
+  ~async_reporter() { Flush(); }
+
+  void OnShould(const std::string& type, const std::string& name, bool disabled) override {
+    auto& out = line();
+    if (colorize_) {
+      out += "\033[0;33m";
+    }
+    out += "[ ";
+    append(out, disabled ? "DISABLED" : type, 8);
+    out += " ] ";
+    if (colorize_) {
+      out += "\033[m";  // Resets the terminal to default.
+    }
+    out += name;
+    out += '\n';
+    commit(out);
+  }
+
+  void OnStep(const std::string& keyword, const std::string& text, const std::string& file, int line) override {
+    auto& out = async_reporter::line();
+    out += "\033[0;96m[ ";
+    append(out, keyword, 8, false);
+    out += " ] ";
+    append(out, text, 60);
+    out += "# ";
+    out += file;
+    out += ':';
+    out += std::to_string(line);
+    out += "\033[m\n";
+    commit(out);
+  }
+
+  void OnScenarioEnd() override {
+    auto& out = line();
+    out += '\n';
+    commit(out);
+  }
+
+  /**
+   * Writes the output of all the threads and stops the writer thread
+   */
+  void Flush() override {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (writer_.joinable()) {
+      auto writer = std::move(writer_);
+      done_ = true;
+      ready_.notify_one();
+      lock.unlock();
+      writer.join();
+      lock.lock();
+      done_ = false;
+    }
+    for (const auto& batch : batches_) {  // submitted while the writer was stopping
+      std::fwrite(batch.data(), 1, batch.size(), out_);
+    }
+    batches_.clear();
+    std::fwrite(buffer_.data(), 1, buffer_.size(), out_);
+    buffer_.clear();
+    std::fflush(out_);
+  }
+
+ private:
+  /**
+   * Formatting buffer of the calling thread, the formatted line is committed right away
+   */
+  static std::string& line() {
+    static thread_local std::string line{};
+    line.clear();
+    return line;
+  }
+
+  void commit(const std::string& out) {
+    if (shared_) {
+      std::fwrite(out.data(), 1, out.size(), out_);
+      return;
+    }
+    std::lock_guard<std::mutex> lock{mutex_};
+    buffer_ += out;
+    if (buffer_.size() >= BATCH_SIZE) {
+      submit();
+    }
+  }
+
+  /**
+   * Hands the buffer over to the writer thread, mutex_ has to be held
+   */
+  void submit() {
+    if (buffer_.empty()) {
+      return;
+    }
+    batches_.push_back(std::move(buffer_));
+    buffer_.clear();
+    buffer_.reserve(BATCH_SIZE);
+    if (not writer_.joinable()) {
+      writer_ = std::thread{[this] { write(); }};
+    }
+    ready_.notify_one();
+  }
+
+  void write() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      ready_.wait(lock, [this] { return done_ || not batches_.empty(); });
+      if (batches_.empty()) {
+        return;
+      }
+      auto batch = std::move(batches_.front());
+      batches_.pop_front();
+      lock.unlock();
+      std::fwrite(batch.data(), 1, batch.size(), out_);
+      std::fflush(out_);
+      lock.lock();
+    }
+  }
+
+  FILE* out_{};
+  bool colorize_{};
+  bool shared_{};
+  std::mutex mutex_{};
+  std::condition_variable ready_{};
+  std::string buffer_{};  // of all the threads, guarded by mutex_
+  std::deque<std::string> batches_{};
+  bool done_{};
+  std::thread writer_{};
+};
+
+/**
+ * Skips formatting altogether (--gunit_quiet)
+ */
+class quiet_reporter : public Reporter {
+ public:
+  void OnShould(const std::string&, const std::string&, bool) override {}
+  void OnStep(const std::string&, const std::string&, const std::string&, int) override {}
+  void OnScenarioEnd() override {}
+  void Flush() override {}
+};
+
+/**
+ * Records the output of a thread or a forked process to be replayed later in order
+ */
+class recording_reporter : public Reporter {
+  struct event {
+    enum { should, step, scenario_end, scenario, step_end } kind;
+    std::string type{};  // or keyword, feature, status
+    std::string name{};  // or text, message
+    std::string file{};
+    int line{};
+    bool disabled{};
+    std::uint64_t duration{};
+    std::vector<std::string> tags{};
+  };
+
+ public:
+  void OnShould(const std::string& type, const std::string& name, bool disabled) override {
+    events_.push_back({event::should, type, name, {}, {}, disabled});
+  }
+
+  void OnStep(const std::string& keyword, const std::string& text, const std::string& file, int line) override {
+    events_.push_back({event::step, keyword, text, file, line, {}});
+  }
+
+  void OnScenarioEnd() override { events_.push_back({event::scenario_end, {}, {}, {}, {}, {}}); }
+
+  void OnScenario(const std::string& feature, const std::string& file, const std::string& name, int line,
+                  const std::vector<std::string>& tags) override {
+    events_.push_back({event::scenario, feature, name, file, line, {}, {}, tags});
+  }
+
+  void OnStepEnd(const std::string& status, std::uint64_t duration, const std::string& message) override {
+    events_.push_back({event::step_end, status, message, {}, {}, {}, duration});
+  }
+
+  void Flush() override {}
+
+  void replay(Reporter& reporter) const {
+    for (const auto& e : events_) {
+      switch (e.kind) {
+        case event::should:
+          reporter.OnShould(e.type, e.name, e.disabled);
+          break;
+        case event::step:
+          reporter.OnStep(e.type, e.name, e.file, e.line);
+          break;
+        case event::scenario_end:
+          reporter.OnScenarioEnd();
+          break;
+        case event::scenario:
+          reporter.OnScenario(e.type, e.file, e.name, e.line, e.tags);
+          break;
+        case event::step_end:
+          reporter.OnStepEnd(e.type, e.duration, e.name);
+          break;
+      }
+    }
+  }
+
+  void save(std::string& out) const {
+    serialize(out, std::uint64_t(events_.size()));
+    for (const auto& e : events_) {
+      serialize(out, e.kind);
+      serialize(out, e.type);
+      serialize(out, e.name);
+      serialize(out, e.file);
+      serialize(out, e.line);
+      serialize(out, e.disabled);
+      serialize(out, e.duration);
+      serialize(out, e.tags);
+    }
+  }
+
+  bool load(string_view& in) {
+    std::uint64_t size{};
+    if (not deserialize(in, size)) {
+      return false;
+    }
+    events_.resize(size);
+    for (auto& e : events_) {
+      if (not deserialize(in, e.kind) || not deserialize(in, e.type) || not deserialize(in, e.name) ||
+          not deserialize(in, e.file) || not deserialize(in, e.line) || not deserialize(in, e.disabled) ||
+          not deserialize(in, e.duration) || not deserialize(in, e.tags)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<event> events_{};
+};
+
+inline void append_json(std::string& out, const std::string& str) {
+  static constexpr char HEX[] = "0123456789abcdef";
+  out += '"';
+  for (const auto c : str) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out += "\\u00";
+          out += HEX[c >> 4];
+          out += HEX[c & 0xf];
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+inline void append_xml(std::string& out, const std::string& str) {
+  for (const auto c : str) {
+    switch (c) {
+      case '&':
+        out += "&amp;";
+        break;
+      case '<':
+        out += "&lt;";
+        break;
+      case '>':
+        out += "&gt;";
+        break;
+      case '"':
+        out += "&quot;";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) >= 0x20 || c == '\n' || c == '\t') {
+          out += c;
+        }
+    }
+  }
+}
+
+/**
+ * Report file written while the tests run (`--gunit_report`), formatted into a buffer appended to the file in large
+ * writes, so that only the current test is kept in memory
+ *
+ * Output of example threads and forked prefixes is recorded per worker and replayed by the test, hence all the events
+ * arrive from the thread running the tests. The report is finished at the end of the first test iteration.
+ */
+class report_writer : public Reporter, public EmptyTestEventListener {
+  static constexpr auto BATCH_SIZE = 256 * 1024;
+
+ public:
+  /**
+   * @throws std::runtime_error when the file can't be created
+   */
+  explicit report_writer(const std::string& path) : file_{std::fopen(path.c_str(), "wb"), &std::fclose} {
+    if (not file_) {
+      throw std::runtime_error("Report \"" + path + "\" can't be written!");
+    }
+  }
+
+  void OnShould(const std::string&, const std::string&, bool) override {}
+  void OnStep(const std::string&, const std::string&, const std::string&, int) override {}
+  void OnScenarioEnd() override {}
+  void Flush() override {}
+
+  void OnTestStart(const TestInfo& info) override { begin_test(info.test_case_name(), info.name()); }
+
+  void OnTestPartResult(const TestPartResult& result) override {
+    if (result.failed()) {
+      add_failure(result.file_name() ? std::string{result.file_name()} + ':' + std::to_string(result.line_number()) +
+                                           '\n' + result.message()
+                                     : result.message());
+    }
+  }
+
+  void OnTestEnd(const TestInfo& info) override { end_test(info.result()->Failed(), info.result()->elapsed_time()); }
+  void OnTestIterationEnd(const UnitTest&, int) override { close(); }
+
+  virtual void begin_test(const std::string& suite, const std::string& name) = 0;
+  virtual void add_failure(const std::string& message) = 0;
+  virtual void end_test(bool failed, TimeInMillis elapsed) = 0;
+
+  /**
+   * Finishes the report, following events are ignored
+   */
+  void close() {
+    if (file_) {
+      finish();
+      write();
+      file_.reset();
+    }
+  }
+
+ protected:
+  virtual void finish() = 0;
+
+  bool is_open() const { return static_cast<bool>(file_); }
+
+  void write_if_full() {
+    if (out_.size() >= BATCH_SIZE) {
+      write();
+    }
+  }
+
+  std::string out_{};
+
+ private:
+  void write() {
+    if (file_) {
+      std::fwrite(out_.data(), 1, out_.size(), file_.get());
+      std::fflush(file_.get());  // nothing is left to be written by forked children
+    }
+    out_.clear();
+  }
+
+  std::unique_ptr<FILE, decltype(&std::fclose)> file_;
+};
+
+/**
+ * Cucumber JSON report (`--gunit_report=cucumber:path`), scenarios of the same file are grouped into a feature
+ *
+ * Failures of a scenario which didn't fail in any step (undefined steps, failures of the hooks) are reported as
+ * a failed after hook.
+ */
+class cucumber_writer : public report_writer {
+ public:
+  explicit cucumber_writer(const std::string& path) : report_writer{path} { out_ += '['; }
+
+  void OnScenario(const std::string& feature, const std::string& file, const std::string& name, int line,
+                  const std::vector<std::string>& tags) override {
+    if (not is_open()) {
+      return;
+    }
+    end_scenario(false);
+    scenario_file_ = file;
+    scenario_feature_ = feature;
+    steps_ = 0;
+    step_open_ = failed_step_ = false;
+    scenario_ += "{\"id\":";
+    append_json(scenario_, id(feature) + ';' + id(name));
+    scenario_ += ",\"keyword\":\"Scenario\",\"type\":\"scenario\",\"name\":";
+    append_json(scenario_, name);
+    scenario_ += ",\"line\":" + std::to_string(line) + ",\"tags\":[";
+    for (auto i = 0u; i < tags.size(); ++i) {
+      scenario_ += i ? ",{\"name\":" : "{\"name\":";
+      append_json(scenario_, tags[i]);
+      scenario_ += '}';
+    }
+    scenario_ += "],\"steps\":[";
+  }
+
+  void OnStep(const std::string& keyword, const std::string& text, const std::string& file, int line) override {
+    if (scenario_.empty()) {
+      return;
+    }
+    end_step();
+    scenario_ += steps_++ ? ",{\"keyword\":" : "{\"keyword\":";
+    append_json(scenario_, keyword + ' ');
+    scenario_ += ",\"name\":";
+    append_json(scenario_, text);
+    scenario_ += ",\"match\":{\"location\":";
+    append_json(scenario_, file + ':' + std::to_string(line));
+    scenario_ += '}';
+    step_open_ = true;
+  }
+
+  void OnStepEnd(const std::string& status, std::uint64_t duration, const std::string& message) override {
+    if (step_open_) {
+      append_result(scenario_, status, duration, message);
+      scenario_ += '}';
+      step_open_ = false;
+      failed_step_ |= not message.empty();
+    }
+  }
+
+  void begin_test(const std::string&, const std::string&) override { failures_.clear(); }
+  void add_failure(const std::string& message) override { failures_ += message + '\n'; }
+  void end_test(bool failed, TimeInMillis) override { end_scenario(failed); }
+
+ protected:
+  void finish() override {
+    end_scenario(false);
+    out_ += feature_file_.empty() ? "]\n" : "]}]\n";
+  }
+
+ private:
+  static std::string id(const std::string& name) {
+    std::string result{};
+    for (const auto c : name) {
+      result += c == ' ' ? '-' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+  }
+
+  static void append_result(std::string& out, const std::string& status, std::uint64_t duration,
+                            const std::string& message) {
+    out += ",\"result\":{\"status\":";
+    append_json(out, status);
+    out += ",\"duration\":" + std::to_string(duration);
+    if (not message.empty()) {
+      out += ",\"error_message\":";
+      append_json(out, message);
+    }
+    out += '}';
+  }
+
+  void end_step() {
+    if (step_open_) {
+      OnStepEnd("skipped", 0, {});
+    }
+  }
+
+  void end_scenario(bool failed) {
+    if (scenario_.empty()) {
+      return;
+    }
+    end_step();
+    scenario_ += ']';
+    if (failed && not failed_step_) {
+      scenario_ += ",\"after\":[{\"match\":{\"location\":";
+      append_json(scenario_, scenario_file_);
+      scenario_ += '}';
+      append_result(scenario_, "failed", 0, failures_.empty() ? std::string{"Scenario has failed"} : failures_);
+      scenario_ += "}]";
+    }
+    scenario_ += '}';
+
+    if (scenario_file_ != feature_file_) {
+      if (not feature_file_.empty()) {
+        out_ += "]},";
+      }
+      feature_file_ = scenario_file_;
+      elements_ = 0;
+      out_ += "{\"uri\":";
+      append_json(out_, feature_file_);
+      out_ += ",\"id\":";
+      append_json(out_, id(scenario_feature_));
+      out_ += ",\"keyword\":\"Feature\",\"name\":";
+      append_json(out_, scenario_feature_);
+      out_ += ",\"elements\":[";
+    }
+    if (elements_++) {
+      out_ += ',';
+    }
+    out_ += scenario_;
+    scenario_.clear();
+    write_if_full();
+  }
+
+  std::string feature_file_{};
+  std::size_t elements_{};  // of the current feature
+  std::string scenario_{};  // being run
+  std::string scenario_file_{};
+  std::string scenario_feature_{};
+  std::size_t steps_{};
+  bool step_open_{};
+  bool failed_step_{};
+  std::string failures_{};  // of the current test
+};
+
+/**
+ * JUnit XML report (`--gunit_report=junit:path`) of all the tests, steps and their results are written to system-out
+ */
+class junit_writer : public report_writer {
+ public:
+  explicit junit_writer(const std::string& path) : report_writer{path} {
+    out_ += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n";
+  }
+
+  void OnShould(const std::string& type, const std::string& name, bool disabled) override {
+    output_ += (disabled ? "DISABLED" : type) + ' ' + name + '\n';
+  }
+
+  void OnScenario(const std::string&, const std::string& file, const std::string&, int line,
+                  const std::vector<std::string>&) override {
+    if (file_.empty()) {
+      file_ = file;
+      line_ = line;
+    }
+  }
+
+  void OnStep(const std::string& keyword, const std::string& text, const std::string&, int) override {
+    output_ += keyword + ' ' + text + '\n';
+  }
+
+  void OnStepEnd(const std::string& status, std::uint64_t duration, const std::string&) override {
+    if (output_.empty()) {
+      return;
+    }
+    output_.back() = ' ';
+    output_ += '(' + status + ", " + std::to_string(duration / 1000) + " us)\n";
+  }
+
+  void begin_test(const std::string& suite, const std::string& name) override {
+    if (not is_open()) {
+      return;
+    }
+    if (suite != suite_) {
+      if (not suite_.empty()) {
+        out_ += "  </testsuite>\n";
+      }
+      suite_ = suite;
+      out_ += "  <testsuite name=\"";
+      append_xml(out_, suite_);
+      out_ += "\">\n";
+    }
+    name_ = name;
+    file_.clear();
+    line_ = 0;
+    failures_.clear();
+    output_.clear();
+  }
+
+  void add_failure(const std::string& message) override {
+    if (failures_.empty()) {
+      message_ = message.substr(0, message.find('\n', message.find('\n') + 1));
+      std::replace(message_.begin(), message_.end(), '\n', ' ');
+    }
+    failures_ += message + '\n';
+  }
+
+  void end_test(bool failed, TimeInMillis elapsed) override {
+    if (not is_open()) {
+      return;
+    }
+    out_ += "    <testcase classname=\"";
+    append_xml(out_, suite_);
+    out_ += "\" name=\"";
+    append_xml(out_, name_);
+    out_ += "\" time=\"" + std::to_string(elapsed / 1000) + '.' + std::to_string(1000 + elapsed % 1000).substr(1) + '"';
+    if (not file_.empty()) {
+      out_ += " file=\"";
+      append_xml(out_, file_);
+      out_ += "\" line=\"" + std::to_string(line_) + '"';
+    }
+    out_ += ">\n";
+    if (failed) {
+      out_ += "      <failure message=\"";
+      append_xml(out_, failures_.empty() ? std::string{"Test has failed"} : message_);
+      out_ += "\">";
+      append_xml(out_, failures_);
+      out_ += "</failure>\n";
+    }
+    if (not output_.empty()) {
+      out_ += "      <system-out>";
+      append_xml(out_, output_);
+      out_ += "</system-out>\n";
+    }
+    out_ += "    </testcase>\n";
+    write_if_full();
+  }
+
+ protected:
+  void finish() override { out_ += suite_.empty() ? "</testsuites>\n" : "  </testsuite>\n</testsuites>\n"; }
+
+ private:
+  std::string suite_{};
+  std::string name_{};
+  std::string file_{};
+  int line_{};
+  std::string message_{};  // of the first failure
+  std::string failures_{};
+  std::string output_{};
+};
+
+/**
+ * @param report `cucumber:path` or `junit:path`
+ * @throws std::runtime_error for unknown formats and files which can't be written
+ */
+inline std::shared_ptr<report_writer> make_report_writer(const std::string& report) {
+  const auto colon = report.find(':');
+  const auto format = report.substr(0, colon);
+  const auto path = colon == std::string::npos ? std::string{} : report.substr(colon + 1);
+  if (format == "cucumber" && not path.empty()) {
+    return std::make_shared<cucumber_writer>(path);
+  }
+  if (format == "junit" && not path.empty()) {
+    return std::make_shared<junit_writer>(path);
+  }
+  throw std::runtime_error("Unknown report \"" + report + "\", expected cucumber:path or junit:path!");
+}
+
+/**
+ * Forwards gtest events to a listener which isn't owned by gtest
+ */
+class shared_listener : public EmptyTestEventListener {
+ public:
+  explicit shared_listener(std::shared_ptr<TestEventListener> listener) : listener_{std::move(listener)} {}
+
+  void OnTestStart(const TestInfo& info) override { listener_->OnTestStart(info); }
+  void OnTestPartResult(const TestPartResult& result) override { listener_->OnTestPartResult(result); }
+  void OnTestEnd(const TestInfo& info) override { listener_->OnTestEnd(info); }
+  void OnTestIterationEnd(const UnitTest& unit_test, int iteration) override {
+    listener_->OnTestIterationEnd(unit_test, iteration);
+  }
+
+ private:
+  std::shared_ptr<TestEventListener> listener_{};
+};
+
+/**
+ * Forwards the output to the console reporter and to the report writers
+ */
+class tee_reporter : public Reporter {
+ public:
+  explicit tee_reporter(std::vector<std::shared_ptr<Reporter>> reporters) : reporters_{std::move(reporters)} {}
+
+  void OnShould(const std::string& type, const std::string& name, bool disabled) override {
+    for (const auto& reporter : reporters_) {
+      reporter->OnShould(type, name, disabled);
+    }
+  }
+
+  void OnStep(const std::string& keyword, const std::string& text, const std::string& file, int line) override {
+    for (const auto& reporter : reporters_) {
+      reporter->OnStep(keyword, text, file, line);
+    }
+  }
+
+  void OnScenarioEnd() override {
+    for (const auto& reporter : reporters_) {
+      reporter->OnScenarioEnd();
+    }
+  }
+
+  void OnScenario(const std::string& feature, const std::string& file, const std::string& name, int line,
+                  const std::vector<std::string>& tags) override {
+    for (const auto& reporter : reporters_) {
+      reporter->OnScenario(feature, file, name, line, tags);
+    }
+  }
+
+  void OnStepEnd(const std::string& status, std::uint64_t duration, const std::string& message) override {
+    for (const auto& reporter : reporters_) {
+      reporter->OnStepEnd(status, duration, message);
+    }
+  }
+
+  void Flush() override {
+    for (const auto& reporter : reporters_) {
+      reporter->Flush();
+    }
+  }
+
+ private:
+  std::vector<std::shared_ptr<Reporter>> reporters_{};
+};
+
+/**
+ * Step results are reported (timed and failures intercepted per step) only for the report files
+ */
+inline bool report_steps() {
+  static const auto enabled = GetBoolFlag("report");
+  return enabled;
+}
+
+inline Reporter*& thread_reporter() {
+  static thread_local Reporter* reporter{};
+  return reporter;
+}
+
+/**
+ * Redirects GetReporter() of the current thread for the lifetime of the object
+ */
+class scoped_reporter {
+ public:
+  explicit scoped_reporter(Reporter& reporter) : previous_{thread_reporter()} { thread_reporter() = &reporter; }
+  ~scoped_reporter() { thread_reporter() = previous_; }
+  scoped_reporter(const scoped_reporter&) = delete;
+  scoped_reporter& operator=(const scoped_reporter&) = delete;
+
+ private:
+  Reporter* previous_{};
+};
+
+inline std::unique_ptr<Reporter>& reporter() {
+  class flush_listener : public EmptyTestEventListener {
+    void OnTestEnd(const TestInfo&) override { reporter()->Flush(); }
+    void OnTestProgramEnd(const UnitTest&) override { reporter()->Flush(); }
+  };
+
+  static std::unique_ptr<Reporter> reporter{[] {
+    UnitTest::GetInstance()->listeners().Append(new flush_listener{});
+    auto console = GetBoolFlag("quiet") ? std::unique_ptr<Reporter>{std::make_unique<quiet_reporter>()}
+                                        : std::unique_ptr<Reporter>{std::make_unique<async_reporter>()};
+    const auto reports = GetFlag("report");
+    if (not report_steps()) {
+      return console;
+    }
+    std::vector<std::shared_ptr<Reporter>> reporters{std::move(console)};
+    for (const auto& report : split(reports, ',')) {
+      const auto writer = make_report_writer(report);
+      UnitTest::GetInstance()->listeners().Append(new shared_listener{writer});
+      reporters.push_back(writer);
+    }
+    return std::unique_ptr<Reporter>{std::make_unique<tee_reporter>(std::move(reporters))};
+  }()};
+  return reporter;
+}
+
+}  // detail
+
+inline Reporter& GetReporter() { return detail::thread_reporter() ? *detail::thread_reporter() : *detail::reporter(); }
+
+/**
+ * Replaces the default reporter, output reported so far is flushed first
+ */
+inline void SetReporter(std::unique_ptr<Reporter> reporter) {
+  detail::reporter()->Flush();
+  detail::reporter() = std::move(reporter);
+}
+
+}  // v1
+}  // testing
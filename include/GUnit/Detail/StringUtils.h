@@ -7,7 +7,14 @@
 //
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -44,6 +51,119 @@ struct make_string<TStr, 0, Chrs...> {
   using type = string<Chrs...>;
 };
 
+/**
+ * Non-owning view of characters (std::string_view isn't available in C++14)
+ */
+class string_view {
+ public:
+  static constexpr auto npos = std::size_t(-1);
+
+  constexpr string_view() = default;
+  constexpr string_view(const char *data, std::size_t size) : data_{data}, size_{size} {}
+  string_view(const char *str) : data_{str}, size_{std::strlen(str)} {}
+  string_view(const std::string &str) : data_{str.data()}, size_{str.size()} {}
+
+  constexpr const char *data() const { return data_; }
+  constexpr std::size_t size() const { return size_; }
+  constexpr bool empty() const { return not size_; }
+  constexpr const char *begin() const { return data_; }
+  constexpr const char *end() const { return data_ + size_; }
+  constexpr char operator[](std::size_t i) const { return data_[i]; }
+
+  constexpr string_view substr(std::size_t pos, std::size_t count = npos) const {
+    return {data_ + pos, count < size_ - pos ? count : size_ - pos};
+  }
+
+  std::string str() const { return {data_, size_}; }
+  explicit operator std::string() const { return str(); }
+
+  friend bool operator==(string_view lhs, string_view rhs) {
+    return lhs.size_ == rhs.size_ && (not lhs.size_ || std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0);
+  }
+  friend bool operator!=(string_view lhs, string_view rhs) { return not(lhs == rhs); }
+  friend std::ostream &operator<<(std::ostream &os, string_view str) { return os.write(str.data_, str.size_); }
+
+ private:
+  const char *data_{};
+  std::size_t size_{};
+};
+
+/**
+ * Raw binary (de)serialization, deserialize returns false when the input is too short
+ */
+template <class T>
+inline void serialize(std::string &out, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+inline void serialize(std::string &out, const std::string &value) {
+  serialize(out, std::uint64_t(value.size()));
+  out += value;
+}
+
+template <class T>
+inline void serialize(std::string &out, const std::vector<T> &values) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  serialize(out, std::uint64_t(values.size()));
+  out.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+inline void serialize(std::string &out, const std::vector<std::string> &values) {
+  serialize(out, std::uint64_t(values.size()));
+  for (const auto &value : values) {
+    serialize(out, value);
+  }
+}
+
+template <class T>
+inline bool deserialize(string_view &in, T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  if (in.size() < sizeof(value)) {
+    return false;
+  }
+  std::memcpy(&value, in.data(), sizeof(value));
+  in = in.substr(sizeof(value));
+  return true;
+}
+
+inline bool deserialize(string_view &in, std::string &value) {
+  std::uint64_t size{};
+  if (not deserialize(in, size) || in.size() < size) {
+    return false;
+  }
+  value.assign(in.data(), size);
+  in = in.substr(size);
+  return true;
+}
+
+template <class T>
+inline bool deserialize(string_view &in, std::vector<T> &values) {
+  static_assert(std::is_trivially_copyable<T>::value, "");
+  std::uint64_t size{};
+  if (not deserialize(in, size) || in.size() / sizeof(T) < size) {
+    return false;
+  }
+  values.resize(size);
+  std::memcpy(values.data(), in.data(), size * sizeof(T));
+  in = in.substr(size * sizeof(T));
+  return true;
+}
+
+inline bool deserialize(string_view &in, std::vector<std::string> &values) {
+  std::uint64_t size{};
+  if (not deserialize(in, size) || in.size() / sizeof(std::uint64_t) < size) {
+    return false;
+  }
+  values.resize(size);
+  for (auto &value : values) {
+    if (not deserialize(in, value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 inline void trim(std::string &txt) {
   txt.erase(0, txt.find_first_not_of(" \n\r\t"));
   txt.erase(txt.find_last_not_of(" \n\r\t") + 1);
@@ -59,13 +179,252 @@ inline std::vector<std::string> split(const std::string &str, char delimiter) {
   return result;
 }
 
+/**
+ * Reads the next row of delimiter separated values (RFC 4180 quoting) from the front of `in`, empty lines are skipped
+ *
+ * Cells are views into `in`, quoted cells with escaped quotes are unescaped into `scratch` (reused between rows).
+ * @return false at the end of the input
+ */
+inline bool read_csv_row(string_view &in, char delimiter, std::vector<string_view> &cells, std::string &scratch) {
+  while (not in.empty() && (in[0] == '\n' || in[0] == '\r')) {
+    in = in.substr(1);
+  }
+  if (in.empty()) {
+    return false;
+  }
+
+  auto quoted = false;
+  auto eol = in.begin();
+  for (; eol != in.end() && (quoted || *eol != '\n'); ++eol) {
+    quoted ^= *eol == '"';
+  }
+  auto row = string_view{in.begin(), std::size_t(eol - in.begin())};
+  in = in.substr(std::min(row.size() + 1, in.size()));
+  if (not row.empty() && row[row.size() - 1] == '\r') {
+    row = row.substr(0, row.size() - 1);
+  }
+
+  cells.clear();
+  scratch.clear();
+  scratch.reserve(row.size());  // unescaped cells are shorter than the row, views into scratch stay valid
+  for (auto first = row.begin();; ++first) {
+    auto last = first;
+    if (first != row.end() && *first == '"') {
+      auto escaped = false;
+      for (last = first + 1; last != row.end(); ++last) {
+        if (*last == '"' && last + 1 != row.end() && last[1] == '"') {
+          escaped = true;
+          ++last;
+        } else if (*last == '"') {
+          break;
+        }
+      }
+      if (escaped) {
+        const auto begin = scratch.size();
+        for (auto it = first + 1; it != last; ++it) {
+          scratch += *it;
+          it += *it == '"';
+        }
+        cells.emplace_back(scratch.data() + begin, scratch.size() - begin);
+      } else {
+        cells.emplace_back(first + 1, std::size_t(last - first - 1));
+      }
+      last = std::find(last, row.end(), delimiter);
+    } else {
+      last = std::find(first, row.end(), delimiter);
+      cells.emplace_back(first, std::size_t(last - first));
+    }
+    if (last == row.end()) {
+      return true;
+    }
+    first = last;
+  }
+}
+
+/**
+ * FNV-1a, chain calls through seed
+ */
+inline std::uint64_t hash(const char *data, std::size_t size, std::uint64_t seed = 14695981039346656037ull) {
+  for (auto i = 0u; i < size; ++i) {
+    seed = (seed ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+  }
+  return seed;
+}
+
+inline std::uint64_t hash(const std::string &str, std::uint64_t seed = 14695981039346656037ull) {
+  return hash(str.data(), str.size(), seed);
+}
+
+/**
+ * Decodes UTF-8 into UTF-32 (wchar_t), every byte of an invalid sequence is replaced with U+FFFD, a leading BOM is skipped
+ *
+ * ASCII is checked and widened 8 bytes at a time.
+ */
+inline std::wstring utf8_decode(const char *data, std::size_t size) {
+  static_assert(sizeof(wchar_t) == 4, "UTF-32 wchar_t is required");
+  constexpr auto replacement = wchar_t(0xFFFD);
+  const auto in = reinterpret_cast<const unsigned char *>(data);
+  std::wstring result(size, wchar_t{});
+  auto out = &result[0];
+  auto i = size >= 3 && in[0] == 0xEF && in[1] == 0xBB && in[2] == 0xBF ? 3u : 0u;
+
+  while (i < size) {
+    for (std::uint64_t chunk{}; i + 8 <= size; i += 8, out += 8) {
+      std::memcpy(&chunk, in + i, sizeof(chunk));
+      if (chunk & 0x8080808080808080ull) {
+        break;
+      }
+      for (auto j = 0; j < 8; ++j) {
+        out[j] = in[i + j];
+      }
+    }
+    if (i >= size) {
+      break;
+    }
+
+    const auto c = in[i];
+    if (c < 0x80) {
+      *out++ = c, ++i;
+      continue;
+    }
+
+    const auto length = c >= 0xF8 ? 0u : c >= 0xF0 ? 4u : c >= 0xE0 ? 3u : c >= 0xC0 ? 2u : 0u;
+    const std::uint32_t smallest[] = {0, 0, 0x80, 0x800, 0x10000};
+    std::uint32_t code = c & (0x7F >> length);
+    auto valid = length && i + length <= size;
+    for (auto j = 1u; valid && j < length; ++j) {
+      valid = (in[i + j] & 0xC0) == 0x80;
+      code = (code << 6) | (in[i + j] & 0x3F);
+    }
+    if (valid && code >= smallest[length] && code <= 0x10FFFF && (code < 0xD800 || code > 0xDFFF)) {
+      *out++ = wchar_t(code), i += length;
+    } else {
+      *out++ = replacement, ++i;
+    }
+  }
+
+  result.resize(out - result.data());
+  return result;
+}
+
+inline const char *skip_spaces(const char *first, const char *last) {
+  while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+    ++first;
+  }
+  return first;
+}
+
+/**
+ * Copies the view into a null terminated buffer, on the stack unless it's longer than the buffer
+ */
+template <std::size_t Size = 64>
+class null_terminated {
+ public:
+  explicit null_terminated(string_view str) {
+    if (str.size() < Size) {
+      std::memcpy(buffer_, str.data(), str.size());
+      buffer_[str.size()] = 0;
+    } else {
+      heap_ = str.str();
+    }
+  }
+
+  operator const char *() const { return heap_.empty() ? buffer_ : heap_.c_str(); }
+
+ private:
+  char buffer_[Size];
+  std::string heap_{};
+};
+
+template <class T>
+using is_char = std::integral_constant<bool, std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+                                                 std::is_same<T, unsigned char>::value>;
+
+}  // detail
+
+/**
+ * Conversion of captured step arguments, might be specialized for user types
+ *
+ * The default uses operator>>, arithmetic and string types are converted without streams.
+ */
+template <class T, class = void>
+struct LexicalCast {
+  static T cast(detail::string_view str) {
+    T var;
+    std::istringstream iss{str.str()};
+    iss >> var;
+    return var;
+  }
+};
+
+template <>
+struct LexicalCast<detail::string_view> {
+  static detail::string_view cast(detail::string_view str) { return str; }
+};
+
+template <>
+struct LexicalCast<std::string> {
+  static std::string cast(detail::string_view str) { return str.str(); }
+};
+
+template <>
+struct LexicalCast<bool> {
+  static bool cast(detail::string_view str) {
+    const auto first = detail::skip_spaces(str.begin(), str.end());
+    const auto value = detail::string_view{first, std::size_t(str.end() - first)};
+    return value.substr(0, 4) == "true" || value.substr(0, 1) == "1";
+  }
+};
+
+/**
+ * Character types (including std::int8_t and std::uint8_t) read a single character, like operator>>
+ */
+template <class T>
+struct LexicalCast<T, std::enable_if_t<detail::is_char<T>::value>> {
+  static T cast(detail::string_view str) {
+    const auto first = detail::skip_spaces(str.begin(), str.end());
+    return first != str.end() ? T(*first) : T{};
+  }
+};
+
+/**
+ * @throws std::out_of_range when the value doesn't fit into T
+ */
+template <class T>
+struct LexicalCast<T, std::enable_if_t<std::is_integral<T>::value && not detail::is_char<T>::value>> {
+  static T cast(detail::string_view str) {
+    auto first = detail::skip_spaces(str.begin(), str.end());
+    const auto negative = first != str.end() && *first == '-';
+    if (first != str.end() && (*first == '-' || *first == '+')) {
+      ++first;
+    }
+    const auto max = std::uint64_t(std::numeric_limits<T>::max());
+    const auto limit = not negative ? max : std::is_signed<T>::value ? max + 1 : 0;
+    std::uint64_t value{};
+    for (; first != str.end() && *first >= '0' && *first <= '9'; ++first) {
+      const auto digit = std::uint64_t(*first - '0');
+      if (digit > limit || value > (limit - digit) / 10) {
+        throw std::out_of_range{"\"" + str.str() + "\" is out of range!"};
+      }
+      value = value * 10 + digit;
+    }
+    return T(negative ? 0 - value : value);
+  }
+};
+
+template <class T>
+struct LexicalCast<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static T cast(detail::string_view str) {
+    const detail::null_terminated<> value{str};
+    return std::is_same<T, long double>::value ? T(std::strtold(value, nullptr)) : T(std::strtod(value, nullptr));
+  }
+};
+
+namespace detail {
+
 template <class T>
-inline auto lexical_cast(const std::string &str) {
-  std::remove_cv_t<std::remove_reference_t<T>> var;
-  std::istringstream iss;
-  iss.str(str);
-  iss >> var;
-  return var;
+inline auto lexical_cast(string_view str) {
+  return LexicalCast<std::remove_cv_t<std::remove_reference_t<T>>>::cast(str);
 }
 
 }  // detail
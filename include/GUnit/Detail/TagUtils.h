@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Tag expression (`@smoke and not (@slow or @wip)`) compiled once into postfix code
+ *
+ * Tags mentioned by the expression are interned into bit positions, matching a scenario computes the mask of its tags
+ * and evaluates the code over it, unknown tags are ignored.
+ */
+class tag_expression {
+  enum class op : char { tag, not_, and_, or_, open };
+  struct instruction {
+    op code;
+    int id;
+  };
+  enum class tribool : char { no, maybe, yes };
+
+ public:
+  using mask_t = std::uint64_t;
+  static constexpr auto MAX_TAGS = 64;
+
+  tag_expression() = default;
+
+  /**
+   * @throws std::invalid_argument when the expression is malformed or mentions more than MAX_TAGS distinct tags
+   */
+  explicit tag_expression(const std::string& expression) {
+    std::vector<op> ops{};
+    auto operand = true;
+    const auto error = [&](const std::string& what) {
+      throw std::invalid_argument("Invalid tag expression \"" + expression + "\": " + what);
+    };
+    const auto precedence = [](op o) { return o == op::not_ ? 3 : o == op::and_ ? 2 : o == op::or_ ? 1 : 0; };
+
+    for (const auto& token : tokenize(expression)) {
+      if (operand) {
+        if (token == "not") {
+          ops.push_back(op::not_);
+        } else if (token == "(") {
+          ops.push_back(op::open);
+        } else if (token[0] == '@' && token.size() > 1) {
+          code_.push_back({op::tag, intern(token, error)});
+          operand = false;
+        } else {
+          error("expected a tag instead of \"" + token + "\"");
+        }
+      } else if (token == "and" || token == "or") {
+        const auto current = token == "and" ? op::and_ : op::or_;
+        while (not ops.empty() && precedence(ops.back()) >= precedence(current)) {
+          code_.push_back({ops.back(), {}});
+          ops.pop_back();
+        }
+        ops.push_back(current);
+        operand = true;
+      } else if (token == ")") {
+        while (not ops.empty() && ops.back() != op::open) {
+          code_.push_back({ops.back(), {}});
+          ops.pop_back();
+        }
+        if (ops.empty()) {
+          error("unbalanced \")\"");
+        }
+        ops.pop_back();
+      } else {
+        error("expected an operator instead of \"" + token + "\"");
+      }
+    }
+
+    if (operand && not(code_.empty() && ops.empty())) {
+      error("unexpected end");
+    }
+    while (not ops.empty()) {
+      if (ops.back() == op::open) {
+        error("unbalanced \"(\"");
+      }
+      code_.push_back({ops.back(), {}});
+      ops.pop_back();
+    }
+  }
+
+  bool empty() const { return code_.empty(); }
+
+  template <class TTags>
+  mask_t mask(const TTags& tags) const {
+    mask_t result{};
+    for (const auto& tag : tags) {
+      const auto it = ids_.find(tag);
+      if (it != ids_.end()) {
+        result |= mask_t(1) << it->second;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @return true when the expression is empty or holds for the given tags
+   */
+  template <class TTags>
+  bool matches(const TTags& tags) const {
+    return eval(mask(tags), ~mask_t{}) == tribool::yes;
+  }
+
+  /**
+   * @param tags known to be set, other tags may or may not be set (ex. feature tags before its scenarios are parsed)
+   * @return false only when the expression can't hold whatever the remaining tags are
+   */
+  template <class TTags>
+  bool may_match(const TTags& tags) const {
+    const auto known = mask(tags);
+    return eval(known, known) != tribool::no;
+  }
+
+ private:
+  static std::vector<std::string> tokenize(const std::string& expression) {
+    std::vector<std::string> tokens{};
+    for (auto it = expression.begin(); it != expression.end();) {
+      if (std::isspace(static_cast<unsigned char>(*it))) {
+        ++it;
+      } else if (*it == '(' || *it == ')') {
+        tokens.emplace_back(1, *it++);
+      } else {
+        const auto end = std::find_if(it, expression.end(), [](char c) {
+          return std::isspace(static_cast<unsigned char>(c)) || c == '(' || c == ')';
+        });
+        tokens.emplace_back(it, end);
+        it = end;
+      }
+    }
+    return tokens;
+  }
+
+  template <class TError>
+  int intern(const std::string& tag, const TError& error) {
+    const auto it = ids_.find(tag);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+    const int id = ids_.size();
+    if (id == MAX_TAGS) {
+      error("more than " + std::to_string(id) + " distinct tags");
+    }
+    ids_.emplace(tag, id);
+    return id;
+  }
+
+  /**
+   * Kleene logic, tags outside of `known` are unknown
+   */
+  tribool eval(mask_t tags, mask_t known) const {
+    if (code_.empty()) {
+      return tribool::yes;
+    }
+    std::vector<tribool> stack{};
+    stack.reserve(code_.size());
+    for (const auto& i : code_) {
+      switch (i.code) {
+        case op::tag: {
+          const auto bit = mask_t(1) << i.id;
+          stack.push_back(tags & bit ? tribool::yes : known & bit ? tribool::no : tribool::maybe);
+        } break;
+        case op::not_:
+          stack.back() = tribool(char(tribool::yes) - char(stack.back()));
+          break;
+        case op::and_:
+        case op::or_: {
+          const auto rhs = stack.back();
+          stack.pop_back();
+          stack.back() = i.code == op::and_ ? std::min(stack.back(), rhs) : std::max(stack.back(), rhs);
+        } break;
+        case op::open:
+          break;
+      }
+    }
+    return stack.back();
+  }
+
+  std::unordered_map<std::string, int> ids_{};
+  std::vector<instruction> code_{};
+};
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+inline std::size_t hardware_threads() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+/**
+ * Calls expr(i) for every i in [0, size) using up to `threads` threads (including the calling one)
+ *
+ * Indices are handed out one by one, the exception thrown for the lowest index is rethrown after all threads have finished.
+ */
+template <class TExpr>
+inline void parallel_for(std::size_t size, const TExpr& expr, std::size_t threads = hardware_threads()) {
+  std::atomic<std::size_t> next{0};
+  std::mutex mutex{};
+  auto failed = size;
+  std::exception_ptr exception{};
+
+  const auto worker = [&] {
+    for (auto i = next++; i < size; i = next++) {
+      try {
+        expr(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (i < failed) {
+          failed = i;
+          exception = std::current_exception();
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> pool{};
+  for (auto i = 1u; i < std::min(threads, size); ++i) {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,279 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include "GUnit/Detail/ProgUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Timeouts in milliseconds, 0 when disabled
+ */
+struct timeouts {
+  std::uint64_t step{};      // `--gunit_step_timeout=ms`
+  std::uint64_t scenario{};  // `--gunit_scenario_timeout=ms`
+  std::uint64_t should{};    // `--gunit_should_timeout=ms`
+};
+
+/**
+ * @throws std::invalid_argument for `--gunit_<name>` without a value
+ */
+inline std::uint64_t get_timeout(const std::string& name) {
+  const auto timeout = GetFlag(name, "0", {});
+  if (timeout.empty()) {
+    throw std::invalid_argument{"--gunit_" + name + " requires a timeout in milliseconds!"};
+  }
+  return std::stoull(timeout);
+}
+
+inline const timeouts& get_timeouts() {
+  static const timeouts t{get_timeout("step_timeout"), get_timeout("scenario_timeout"), get_timeout("should_timeout")};
+  return t;
+}
+
+/**
+ * Single background thread enforcing the deadlines of the running threads
+ *
+ * When a deadline expires, the stack of the stuck thread is dumped and
+ *  - the forked child the thread is waiting for is killed (after a grace period to let the child dump its own stack),
+ *  - a forked child kills itself, so that the parent reports its scenarios as failed and continues,
+ *  - otherwise the program exits, as the stuck thread can't be stopped. Nothing is reported to gtest from the watchdog
+ *    thread, the message is only written to stderr, so that the reports are left unfinished.
+ *
+ * The stack is dumped with SIGUSR2, unless the application has already installed its own handler for it.
+ */
+class watchdog {
+  using clock = std::chrono::steady_clock;
+  static constexpr auto DUMP_SIGNAL = SIGUSR2;
+  static constexpr auto GRACE_MS = 1000;
+  static constexpr auto MAX_FRAMES = 64;
+
+  struct entry {
+    clock::time_point deadline{};
+    std::uint64_t timeout{};
+    std::string what{};
+    pthread_t thread{};
+    pid_t child{};  // the thread is waiting for
+    bool grace{};
+  };
+
+ public:
+  static watchdog& instance() {
+    static auto* w = new watchdog{};  // never destroyed, the detached thread outlives main
+    return *w;
+  }
+
+  /**
+   * @return id of the deadline of the calling thread
+   */
+  std::uint64_t arm(std::uint64_t timeout, const std::string& what) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    start();
+    entries_.emplace(++last_id_, entry{clock::now() + std::chrono::milliseconds{timeout}, timeout, what, pthread_self()});
+    changed_->notify_one();
+    return last_id_;
+  }
+
+  void disarm(std::uint64_t id) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    entries_.erase(id);
+  }
+
+  /**
+   * Deadlines of the calling thread expiring while it waits for the child kill the child, 0 when done waiting
+   */
+  void wait_for(pid_t child) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (pthread_equal(it->second.thread, pthread_self())) {
+        if (not child && it->second.grace) {
+          it = entries_.erase(it);  // expired in the child, which has already been reported
+          continue;
+        }
+        it->second.child = child;
+      }
+      ++it;
+    }
+  }
+
+ private:
+  watchdog() {
+    struct sigaction previous {};
+    sigaction(DUMP_SIGNAL, nullptr, &previous);
+    if (not(previous.sa_flags & SA_SIGINFO) && previous.sa_handler == SIG_DFL) {
+      struct sigaction action {};
+      action.sa_handler = &watchdog::on_dump;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      dumpable_ = not sigaction(DUMP_SIGNAL, &action, nullptr);
+    }
+    void* frame{};
+    backtrace(&frame, 1);  // loads the unwinder, which isn't async-signal-safe, ahead of the signal handler
+    pthread_atfork([] { instance().mutex_.lock(); }, [] { instance().mutex_.unlock(); }, [] { instance().forked(); });
+  }
+
+  void start() {
+    if (not running_) {
+      running_ = true;
+      std::thread{[this] { run(); }}.detach();
+    }
+  }
+
+  /**
+   * Only the forking thread survives in the child, it keeps its deadlines enforced by a new watchdog thread. The condition
+   * variable the watchdog thread of the parent was waiting on is leaked, as it can't be destroyed in the child.
+   */
+  void forked() {
+    changed_ = new std::condition_variable{};
+    running_ = false;
+    child_ = true;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      it = pthread_equal(it->second.thread, pthread_self()) ? std::next(it) : entries_.erase(it);
+    }
+    if (not entries_.empty()) {
+      start();
+    }
+    mutex_.unlock();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      auto next = entries_.end();
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (next == entries_.end() || it->second.deadline < next->second.deadline) {
+          next = it;
+        }
+      }
+      if (next == entries_.end()) {
+        changed_->wait(lock);
+      } else if (clock::now() < next->second.deadline) {
+        changed_->wait_until(lock, next->second.deadline);
+      } else if (next->second.child && not next->second.grace) {
+        next->second.grace = true;
+        next->second.deadline += std::chrono::milliseconds{std::int64_t(GRACE_MS)};
+      } else {
+        const auto expired = next->second;
+        entries_.erase(next);
+        lock.unlock();
+        expire(expired);
+        lock.lock();
+      }
+    }
+  }
+
+  void expire(const entry& e) {
+    const auto message = e.what + " has exceeded the timeout of " + std::to_string(e.timeout) + " ms";
+    if (e.child) {
+      kill(e.child, SIGKILL);
+      std::fprintf(stderr, "[ TIMEOUT  ] %s, the forked process %d has been killed\n", message.c_str(), int(e.child));
+      return;
+    }
+
+    const auto stack = dump(e.thread);
+    std::fprintf(stderr, "[ TIMEOUT  ] %s\nStack of the stuck thread:\n    %s\n", message.c_str(), stack.c_str());
+    std::fflush(nullptr);
+    if (child_) {
+      kill(getpid(), SIGKILL);  // the parent reports the scenarios of the child as failed
+    }
+    std::_Exit(1);
+  }
+
+  /**
+   * @return call stack of the thread, captured by the thread itself in the signal handler and symbolized here
+   */
+  std::string dump(pthread_t thread) {
+    dumped_ = false;
+    if (not dumpable_ || pthread_kill(thread, DUMP_SIGNAL)) {
+      return "unavailable";
+    }
+    for (auto i = 0; i < GRACE_MS && not dumped_; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return dumped_ ? call_stack(frames_, frames_size_, "\n    ", 2, 32) : "unavailable";
+  }
+
+  /**
+   * Only async-signal-safe calls, the raw frames are written into the preallocated array
+   */
+  static void on_dump(int) {
+    auto& w = instance();
+    w.frames_size_ = backtrace(w.frames_, MAX_FRAMES);
+    w.dumped_ = true;
+  }
+
+  std::mutex mutex_{};
+  std::condition_variable* changed_{new std::condition_variable{}};
+  std::map<std::uint64_t, entry> entries_{};
+  std::uint64_t last_id_{};
+  bool running_{};
+  bool child_{};     // forked
+  bool dumpable_{};  // the dump signal handler is installed
+  void* frames_[MAX_FRAMES]{};
+  int frames_size_{};
+  std::atomic<bool> dumped_{};
+};
+
+/**
+ * Deadline of the calling thread for the lifetime of the object, disabled for the timeout 0
+ */
+class deadline {
+ public:
+  deadline() = default;
+  deadline(std::uint64_t timeout, const std::string& what) : id_{timeout ? watchdog::instance().arm(timeout, what) : 0} {}
+  deadline(deadline&& other) noexcept : id_{other.id_} { other.id_ = {}; }
+  deadline& operator=(deadline&& other) noexcept {
+    std::swap(id_, other.id_);
+    return *this;
+  }
+  ~deadline() {
+    if (id_) {
+      watchdog::instance().disarm(id_);
+    }
+  }
+
+ private:
+  std::uint64_t id_{};
+};
+
+/**
+ * Runs expr(write) in a forked child, deadlines of the calling thread expiring meanwhile kill only the child
+ */
+template <class TExpr>
+inline forked_result run_forked_with_deadlines(const TExpr& expr) {
+  auto& w = watchdog::instance();  // before the fork, so that the child knows it's been forked
+  struct waiting {
+    watchdog& w;
+    ~waiting() { w.wait_for({}); }
+  } done{w};
+  (void)done;
+  return run_forked(expr, [&w](pid_t child) { w.wait_for(child); });
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#pragma once
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+/**
+ * Notifies about written files (inotify, Linux only)
+ *
+ * Directories of the files are watched, editors usually save by renaming a temporary file over the original one.
+ */
+class file_watcher {
+  static constexpr auto EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+ public:
+  /**
+   * @throws std::runtime_error when inotify isn't available
+   */
+  explicit file_watcher(const std::vector<std::string>& paths) : fd_{::inotify_init1(IN_CLOEXEC)} {
+    if (fd_ < 0) {
+      throw std::runtime_error("inotify is not available!");
+    }
+    std::map<std::string, int> directories{};
+    for (const auto& path : paths) {
+      const auto slash = path.find_last_of('/');
+      const auto directory = slash == std::string::npos ? std::string{"."} : path.substr(0, slash + !slash);
+      auto it = directories.find(directory);
+      if (it == directories.end()) {
+        it = directories.emplace(directory, ::inotify_add_watch(fd_, directory.c_str(), EVENTS)).first;
+      }
+      if (it->second >= 0) {
+        files_.emplace(std::make_pair(it->second, path.substr(slash + 1)), path);
+      }
+    }
+  }
+
+  file_watcher(const file_watcher&) = delete;
+  file_watcher& operator=(const file_watcher&) = delete;
+  ~file_watcher() { ::close(fd_); }
+
+  /**
+   * Blocks until some of the files are written, events following within `settle_ms` are coalesced
+   *
+   * @return written files (as passed to the constructor), each of them once
+   */
+  std::vector<std::string> wait(int settle_ms = 50) {
+    std::vector<std::string> changed{};
+    for (;;) {
+      if (not read_events(changed.empty() ? -1 : settle_ms, changed) && not changed.empty()) {
+        return changed;
+      }
+    }
+  }
+
+ private:
+  bool read_events(int timeout, std::vector<std::string>& changed) {
+    pollfd p{fd_, POLLIN, 0};
+    const auto ready = ::poll(&p, 1, timeout);
+    if (ready < 0 && errno != EINTR) {
+      throw std::runtime_error("inotify poll failed!");
+    }
+    if (ready <= 0) {
+      return false;
+    }
+    alignas(inotify_event) char buffer[4096];
+    const auto size = ::read(fd_, buffer, sizeof(buffer));
+    for (auto i = decltype(size){}; i < size;) {
+      const auto& event = *reinterpret_cast<const inotify_event*>(buffer + i);
+      i += sizeof(inotify_event) + event.len;
+      const auto it = event.len ? files_.find({event.wd, event.name}) : files_.end();
+      if (it != files_.end() && std::find(changed.begin(), changed.end(), it->second) == changed.end()) {
+        changed.push_back(it->second);
+      }
+    }
+    return size > 0;
+  }
+
+  int fd_{};
+  std::map<std::pair<int, std::string>, std::string> files_{};  // (watch, name) -> path
+};
+
+}  // detail
+}  // v1
+}  // testing
+#endif
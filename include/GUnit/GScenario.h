@@ -7,21 +7,39 @@
 //
 #pragma once
 
+#include <gtest/gtest-spi.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <deque>
 #include <functional>
 #include <gherkin.hpp>
 #include <json.hpp>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
+#include "GUnit/Detail/CacheUtils.h"
 #include "GUnit/Detail/FileUtils.h"
 #include "GUnit/Detail/Preprocessor.h"
+#include "GUnit/Detail/ProfileUtils.h"
 #include "GUnit/Detail/RegexUtils.h"
+#include "GUnit/Detail/RegistryUtils.h"
+#include "GUnit/Detail/ReportUtils.h"
 #include "GUnit/Detail/StringUtils.h"
+#include "GUnit/Detail/TagUtils.h"
+#include "GUnit/Detail/ThreadUtils.h"
+#include "GUnit/Detail/TimeoutUtils.h"
 #include "GUnit/Detail/Utility.h"
+#include "GUnit/Detail/WatchUtils.h"
 
 namespace testing {
 inline namespace v1 {
@@ -34,28 +52,268 @@ struct StepIsAmbiguous : std::runtime_error {
 
 using Table = std::vector<std::unordered_map<std::string, std::string>>;
 
+namespace detail {
+struct text {
+  std::size_t offset;
+  std::size_t size;
+};
+}  // detail
+
+/**
+ * Data table of a step, cells are views into the scenario which are valid during the step call
+ *
+ * The first row is the header, rows are indexed from the first row after the header.
+ */
+class DataTable {
+ public:
+  class Row {
+   public:
+    Row(const DataTable& table, const detail::text* cells) : table_{&table}, cells_{cells} {}
+
+    std::size_t size() const { return table_->columns(); }
+    detail::string_view operator[](std::size_t column) const { return table_->view(cells_[column]); }
+    detail::string_view operator[](const std::string& name) const { return (*this)[table_->column(name)]; }
+
+   private:
+    const DataTable* table_{};
+    const detail::text* cells_{};
+  };
+
+  class iterator {
+   public:
+    iterator(const DataTable& table, std::size_t row) : table_{&table}, row_{row} {}
+    Row operator*() const { return (*table_)[row_]; }
+    iterator& operator++() {
+      ++row_;
+      return *this;
+    }
+    bool operator==(const iterator& other) const { return row_ == other.row_; }
+    bool operator!=(const iterator& other) const { return row_ != other.row_; }
+
+   private:
+    const DataTable* table_{};
+    std::size_t row_{};
+  };
+
+  DataTable() = default;
+  DataTable(detail::string_view arena, const detail::text* cells, std::size_t columns, std::size_t rows)
+      : arena_{arena}, cells_{cells}, columns_{columns}, rows_{rows} {}
+
+  std::size_t size() const { return rows_ ? rows_ - 1 : 0; }
+  bool empty() const { return not size(); }
+  std::size_t columns() const { return columns_; }
+  detail::string_view header(std::size_t column) const { return view(cells_[column]); }
+
+  /**
+   * @return index of the column, to be looked up once and used for all rows
+   */
+  std::size_t column(const std::string& name) const {
+    for (auto i = 0u; i < columns_; ++i) {
+      if (header(i) == name) {
+        return i;
+      }
+    }
+    throw std::out_of_range{"Column \"" + name + "\" not found!"};
+  }
+
+  Row operator[](std::size_t row) const { return {*this, cells_ + (row + 1) * columns_}; }
+  iterator begin() const { return {*this, 0}; }
+  iterator end() const { return {*this, size()}; }
+
+  /**
+   * Map per row Table adapter
+   */
+  operator Table() const {
+    Table table{};
+    table.reserve(size());
+    for (const auto& row : *this) {
+      std::unordered_map<std::string, std::string> r{};
+      for (auto i = 0u; i < columns_; ++i) {
+        r[header(i).str()] = row[i].str();
+      }
+      table.push_back(std::move(r));
+    }
+    return table;
+  }
+
+ private:
+  detail::string_view view(const detail::text& t) const { return arena_.substr(t.offset, t.size); }
+
+  detail::string_view arena_{};
+  const detail::text* cells_{};
+  std::size_t columns_{};
+  std::size_t rows_{};
+};
+
+/**
+ * External CSV/TSV data table of a step (`Given the orders from 'data/orders.csv'`), parsed lazily row by row
+ *
+ * The file is mapped into memory and only the current row is held by an iterator, memory doesn't grow with the number
+ * of rows. The first row is the header, values are tab separated in `.tsv` files and comma separated otherwise.
+ * Cells of a row are valid until the iterator is incremented.
+ */
+class DataFile {
+ public:
+  class Row {
+   public:
+    Row(const DataFile& file, const std::vector<detail::string_view>& cells) : file_{&file}, cells_{&cells} {}
+
+    std::size_t size() const { return cells_->size(); }
+    detail::string_view operator[](std::size_t column) const { return (*cells_)[column]; }
+    detail::string_view operator[](const std::string& name) const { return (*this)[file_->column(name)]; }
+
+   private:
+    const DataFile* file_{};
+    const std::vector<detail::string_view>* cells_{};
+  };
+
+  class iterator {
+   public:
+    iterator() = default;
+    iterator(const DataFile& file, detail::string_view data) : file_{&file}, data_{data} { ++*this; }
+
+    /**
+     * Cells might be views into the scratch buffer of the copied iterator, the current row is parsed again
+     */
+    iterator(const iterator& other) : file_{other.file_}, data_{other.row_} {
+      if (file_) {
+        ++*this;
+      }
+    }
+    iterator& operator=(const iterator& other) {
+      file_ = other.file_;
+      data_ = other.row_;
+      if (file_) {
+        ++*this;
+      }
+      return *this;
+    }
+
+    Row operator*() const { return {*file_, cells_}; }
+    iterator& operator++() {
+      row_ = data_;
+      if (not detail::read_csv_row(data_, file_->delimiter_, cells_, scratch_)) {
+        file_ = nullptr;
+        row_ = data_ = {};
+      }
+      return *this;
+    }
+    bool operator==(const iterator& other) const { return file_ == other.file_ && row_.data() == other.row_.data(); }
+    bool operator!=(const iterator& other) const { return not(*this == other); }
+
+   private:
+    const DataFile* file_{};
+    detail::string_view row_{};   // current row
+    detail::string_view data_{};  // after the current row
+    std::vector<detail::string_view> cells_{};
+    std::string scratch_{};
+  };
+
+  /**
+   * @throws std::runtime_error when the file can't be opened
+   */
+  explicit DataFile(const std::string& path)
+      : file_{std::make_shared<const detail::mapped_file>(path)},
+        delimiter_{path.size() >= 4 && path.compare(path.size() - 4, 4, ".tsv") == 0 ? '\t' : ','} {
+    if (not file_->is_open()) {
+      throw std::runtime_error("File \"" + path + "\" not found!");
+    }
+    if (not file_->empty()) {
+      ::madvise(const_cast<char*>(file_->data()), file_->size(), MADV_SEQUENTIAL);
+    }
+    data_ = {file_->data(), file_->size()};
+    std::string scratch{};
+    std::vector<detail::string_view> header{};
+    if (detail::read_csv_row(data_, delimiter_, header, scratch)) {
+      for (const auto& name : header) {
+        header_.push_back(name.str());
+      }
+    }
+  }
+
+  std::size_t columns() const { return header_.size(); }
+  const std::string& header(std::size_t column) const { return header_[column]; }
+
+  /**
+   * @return index of the column, to be looked up once and used for all rows
+   */
+  std::size_t column(const std::string& name) const {
+    const auto it = std::find(header_.begin(), header_.end(), name);
+    if (it == header_.end()) {
+      throw std::out_of_range{"Column \"" + name + "\" not found!"};
+    }
+    return it - header_.begin();
+  }
+
+  iterator begin() const { return {*this, data_}; }
+  iterator end() const { return {}; }
+
+ private:
+  std::shared_ptr<const detail::mapped_file> file_{};
+  char delimiter_{};
+  detail::string_view data_{};  // rows after the header
+  std::vector<std::string> header_{};
+};
+
+template <>
+struct LexicalCast<DataFile> {
+  static DataFile cast(detail::string_view path) { return DataFile{path.str()}; }
+};
+
 class Steps;
 
 #if defined(__clang__)
 #pragma clang diagnostic ignored "-Wgnu-string-literal-operator-template"
 #endif
 
+namespace detail {
+/**
+ * Step pattern written as a Cucumber expression
+ */
+template <char... Chrs>
+struct expression : string<Chrs...> {};
+
+template <class>
+struct is_expression : std::false_type {};
+
+template <char... Chrs>
+struct is_expression<expression<Chrs...>> : std::true_type {};
+}  // detail
+
 template <class T, T... Chrs>
 constexpr auto operator""_step() {
   return detail::string<Chrs...>{};
 }
 
+template <class T, T... Chrs>
+constexpr auto operator""_expression() {
+  return detail::expression<Chrs...>{};
+}
+
 namespace detail {
 
 struct step_info {
-  std::string name{};
-  std::string file{};
+  const char* name{""};
+  const char* file{""};
   int line{};
 };
 
-using call_step_t = std::function<void(const std::string&, const Table&)>;
+using call_step_t = std::function<void(const char*, const std::string&, const DataTable&)>;
 using step_info_call_step_t = std::pair<step_info, call_step_t>;
-using step_info_call_map_t = std::unordered_map<std::string, step_info_call_step_t>;
+
+/**
+ * Patterns known at compile time (`_step`, `_expression`) are kept by pointer, the others are copied
+ */
+struct step_definition {
+  std::string pattern{};
+  step_info_call_step_t step{};
+  bool expression{};  // Cucumber expression
+  const char* literal{};  // compile-time pattern, unique per text
+
+  const char* text() const { return literal ? literal : pattern.c_str(); }
+};
+
+using step_definitions_t = std::deque<step_definition>;
 
 template <class T>
 void MakeAndRegisterTestInfo(const T& test, const std::string& type, const std::string& name, const std::string& /*file*/,
@@ -73,78 +331,547 @@ void MakeAndRegisterTestInfo(const T& test, const std::string& type, const std::
                                     internal::GetTestTypeId(), Test::SetUpTestCase, Test::TearDownTestCase, test);
 }
 
-inline auto parse(const std::string& feature, const std::wstring& content) {
-  gherkin::parser parser{L"en"};
-  gherkin::compiler compiler{feature};
-  const auto gherkin_document = parser.parse(content);
-  return compiler.compile(gherkin_document);
-}
+/**
+ * Pickle converted once from the gherkin compiler output, texts are kept in a single arena
+ */
+class pickle {
+ public:
+  struct step {
+    text value;
+    int line;
+    std::size_t cells;    // index of the first table cell
+    std::size_t columns;  // table header included in rows
+    std::size_t rows;
+  };
 
-inline auto make_table(const nlohmann::json& step) {
-  Table table{};
-  std::vector<std::string> ids{};
-  for (const auto& argument : step["arguments"]) {
-    auto first = true;
-    for (const auto& row : argument["rows"]) {
-      if (first) {
-        for (const auto& cell : row["cells"]) {
-          ids.push_back(cell["value"]);
+  pickle() = default;
+
+  explicit pickle(const nlohmann::json& json) {
+    for (const auto& s : json["steps"]) {
+      step current{add(s["text"]), s["locations"].back()["line"].get<int>(), cells_.size(), 0, 0};
+      for (const auto& argument : s["arguments"]) {
+        if (argument.count("rows")) {
+          for (const auto& row : argument["rows"]) {
+            current.columns = row["cells"].size();
+            ++current.rows;
+            for (const auto& cell : row["cells"]) {
+              cells_.push_back(add(cell["value"]));
+            }
+          }
         }
-        first = false;
+      }
+      steps_.push_back(current);
+    }
+    arena_.shrink_to_fit();
+  }
+
+  const std::vector<step>& steps() const { return steps_; }
+
+  std::string str(const step& s) const { return str(s.value); }
+
+  DataTable table(const step& s) const { return {arena_, cells_.data() + s.cells, s.columns, s.rows}; }
+
+  /**
+   * @return true when the step has the same text and table as the step of the other pickle
+   */
+  bool same(const step& s, const pickle& other, const step& o) const {
+    if (view(s.value) != other.view(o.value) || s.columns != o.columns || s.rows != o.rows) {
+      return false;
+    }
+    for (auto i = 0u; i < s.columns * s.rows; ++i) {
+      if (view(cells_[s.cells + i]) != other.view(other.cells_[o.cells + i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @return hash of the texts and tables of the steps, lines aren't included
+   */
+  std::uint64_t hash() const {
+    auto result = detail::hash(std::string{});
+    const auto add = [&result](string_view str) {
+      const std::uint64_t size = str.size();
+      result = detail::hash(reinterpret_cast<const char*>(&size), sizeof(size), result);
+      result = detail::hash(str.data(), str.size(), result);
+    };
+    for (const auto& s : steps_) {
+      add(view(s.value));
+      add(std::to_string(s.columns));
+      for (auto i = 0u; i < s.columns * s.rows; ++i) {
+        add(view(cells_[s.cells + i]));
+      }
+    }
+    return result;
+  }
+
+  void save(std::string& out) const {
+    serialize(out, arena_);
+    serialize(out, cells_);
+    serialize(out, steps_);
+  }
+
+  static bool load(string_view& in, pickle& p) {
+    return deserialize(in, p.arena_) && deserialize(in, p.cells_) && deserialize(in, p.steps_);
+  }
+
+ private:
+  text add(const nlohmann::json& json) {
+    const auto& str = json.get_ref<const std::string&>();
+    const text t{arena_.size(), str.size()};
+    arena_ += str;
+    return t;
+  }
+
+  std::string str(const text& t) const { return arena_.substr(t.offset, t.size); }
+  string_view view(const text& t) const { return string_view{arena_}.substr(t.offset, t.size); }
+
+  std::string arena_{};
+  std::vector<text> cells_{};
+  std::vector<step> steps_{};
+};
+
+/**
+ * Trie of the step patterns, the last definition of a pattern wins
+ */
+class compiled_steps {
+  struct pattern {
+    const char* literal;  // compile-time pattern
+    std::string text;
+    bool expression;  // Cucumber expression
+  };
+
+ public:
+  explicit compiled_steps(const step_definitions_t& definitions) {
+    std::unordered_map<std::string, std::size_t> last{};
+    for (auto i = 0u; i < definitions.size(); ++i) {
+      patterns_.push_back({definitions[i].literal, definitions[i].text(), definitions[i].expression});
+      last[patterns_.back().text] = i;
+    }
+    for (auto i = 0u; i < patterns_.size(); ++i) {
+      if (last[patterns_[i].text] != i) {
+        continue;
+      }
+      if (patterns_[i].expression) {
+        matcher_.add(cucumber_expression{patterns_[i].text}, i);
       } else {
-        std::unordered_map<std::string, std::string> r;
-        int i = 0;
-        for (const auto& cell : row["cells"]) {
-          std::string value = cell["value"];
-          r[ids[i++]] = value;
-        }
-        table.push_back(r);
+        matcher_.add(patterns_[i].text, i);
       }
     }
   }
-  return table;
+
+  /**
+   * Compile-time patterns are compared by address, the others by text
+   */
+  bool matches(const step_definitions_t& definitions) const {
+    const auto same = [](const pattern& p, const step_definition& definition) {
+      return p.expression == definition.expression &&
+             ((p.literal && p.literal == definition.literal) || p.text == definition.text());
+    };
+    return definitions.size() == patterns_.size() &&
+           std::equal(patterns_.begin(), patterns_.end(), definitions.begin(), same);
+  }
+
+  const std::vector<std::size_t>& find(const std::string& step) const { return matcher_.find(step); }
+
+ private:
+  std::vector<pattern> patterns_{};
+  step_matcher matcher_{};
+};
+
+/**
+ * Compiled steps of the first scenario run by a STEPS block, frozen and reused by the following scenarios of all its
+ * features as long as they define the same patterns in the same order
+ */
+class step_registry {
+ public:
+  std::shared_ptr<const compiled_steps> get(const step_definitions_t& definitions) {
+    auto compiled = std::atomic_load(&compiled_);
+    if (compiled && compiled->matches(definitions)) {
+      return compiled;
+    }
+    auto built = std::make_shared<const compiled_steps>(definitions);
+    if (not compiled) {
+      std::atomic_compare_exchange_strong(&compiled_, &compiled, built);
+    }
+    return built;
+  }
+
+ private:
+  std::shared_ptr<const compiled_steps> compiled_{};
+};
+
+/**
+ * Step definitions profiled with `--gunit_profile[=path]`, nullptr when disabled
+ *
+ * The profiles sorted by the total duration are printed at the end of the tests and exported as JSON
+ * (.gunit/profile.json by default). Steps run by forked children (`--gunit_shared_prefix`) aren't profiled.
+ */
+inline detail::step_profiler* profiler() {
+  class profile_listener : public EmptyTestEventListener {
+   public:
+    profile_listener(const detail::step_profiler& profiler, const std::string& path)
+        : profiler_{profiler}, path_{path} {}
+
+    void OnTestIterationEnd(const UnitTest&, int) override {
+      const auto profiles = profiler_.profiles();
+      const auto table = format_profiles(profiles);
+      std::fwrite(table.data(), 1, table.size(), stdout);
+      std::fflush(stdout);
+
+      const auto dir = path_.find_last_of('/');
+      if (dir != std::string::npos) {
+        ::mkdir(path_.substr(0, dir).c_str(), 0755);
+      }
+      const auto json = profiles_to_json(profiles);
+      std::unique_ptr<FILE, decltype(&std::fclose)> file{std::fopen(path_.c_str(), "wb"), &std::fclose};
+      if (not file || std::fwrite(json.data(), 1, json.size(), file.get()) != json.size()) {
+        std::printf("[  ERROR   ] Profile \"%s\" can't be written!\n", path_.c_str());
+      }
+    }
+
+   private:
+    const detail::step_profiler& profiler_;
+    std::string path_{};
+  };
+
+  static const auto instance = [] {
+    const auto path = GetFlag("profile", {}, ".gunit/profile.json");
+    if (path.empty()) {
+      return std::unique_ptr<detail::step_profiler>{};
+    }
+    auto profiler = std::make_unique<detail::step_profiler>();
+    UnitTest::GetInstance()->listeners().Append(
+        new profile_listener{*profiler, path});
+    return profiler;
+  }();
+  return instance.get();
 }
 
-inline void run(const std::string& feature_file, const std::string& pickles, const std::function<void()>& before,
-                const step_info_call_map_t& steps, const std::function<void()>& after) {
-  const auto json = nlohmann::json::parse(pickles)["pickle"];
-  for (const auto& expected_step : json["steps"]) {
-    std::string text = expected_step["text"];
-    auto found = false;
-    for (const auto& given_step : steps) {
-      if (detail::match(given_step.first, text)) {
-        if (found) {
-          throw StepIsAmbiguous{"STEP \"" + text + "\" is ambiguous!"};
-        }
-        const auto name = given_step.second.first.name;
-        const auto full_file = given_step.second.first.file.empty() ? feature_file : given_step.second.first.file;
-        const auto file = full_file.substr(full_file.find_last_of("/\\") + 1);
-        const auto line = not given_step.second.first.line ? expected_step["locations"].back()["line"].get<int>()
-                                                           : given_step.second.first.line;
-
-        std::cout << "\033[0;96m"
-                  << "[ " << std::right << std::setw(8) << name << " ] " << std::left << std::setw(60) << text << "# " << file
-                  << ":" << line << "\033[m" << '\n';
-        if (before) {
-          before();
+/**
+ * Runs the step and reports its result and duration when step results are reported (`--gunit_report`)
+ *
+ * Failures of the step are intercepted to be attributed to the step and reported again afterwards.
+ */
+template <class TExpr>
+inline void report_step(const TExpr& expr) {
+  if (not report_steps()) {
+    expr();
+    return;
+  }
+
+  TestPartResultArray failures{};
+  std::string message{};
+  const auto start = std::chrono::steady_clock::now();
+  const auto report = [&] {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    for (auto i = 0; i < failures.size(); ++i) {
+      if (failures.GetTestPartResult(i).failed()) {
+        message += message.empty() ? "" : "\n";
+        message += failures.GetTestPartResult(i).message();
+      }
+    }
+    GetReporter().OnStepEnd(message.empty() ? "passed" : "failed", duration.count(), message);
+    for (auto i = 0; i < failures.size(); ++i) {
+      const auto& failure = failures.GetTestPartResult(i);
+      internal::AssertHelper(failure.type(), failure.file_name(), failure.line_number(), failure.message()) = Message();
+    }
+  };
+
+  try {
+    const ScopedFakeTestPartResultReporter intercept{ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD,
+                                                     &failures};
+    expr();
+  } catch (const std::exception& e) {
+    message = e.what();
+    report();
+    throw;
+  } catch (...) {
+    message = "Unknown C++ exception";
+    report();
+    throw;
+  }
+  report();
+}
+
+inline void run_step(const std::string& feature_file, const compiled_steps& compiled,
+                     const step_definitions_t& definitions, const pickle& pickle, const pickle::step& expected_step,
+                     const std::function<void()>& before, const std::function<void()>& after) {
+  const auto text = pickle.str(expected_step);
+  const auto& found = compiled.find(text);
+  if (found.empty()) {
+    throw StepIsNotImplemented{"STEP \"" + text + "\" not implemented!"};
+  }
+  if (found.size() > 1) {
+    throw StepIsAmbiguous{"STEP \"" + text + "\" is ambiguous!"};
+  }
+
+  const auto& given_step = definitions[found.front()].step;
+  const std::string name = given_step.first.name;
+  const auto full_file = *given_step.first.file ? std::string{given_step.first.file} : feature_file;
+  const auto file = full_file.substr(full_file.find_last_of("/\\") + 1);
+  const auto line = not given_step.first.line ? expected_step.line : given_step.first.line;
+
+  GetReporter().OnStep(name, text, file, line);
+  const auto pattern = definitions[found.front()].text();
+  const auto profile = profiler();
+  const auto timeout = get_timeouts().step;
+  const auto step_deadline = timeout ? deadline{timeout, "Step \"" + text + "\""} : deadline{};
+  report_step([&] {
+    if (not profile) {
+      if (before) {
+        before();
+      }
+      given_step.second(pattern, text, pickle.table(expected_step));
+      if (after) {
+        after();
+      }
+      return;
+    }
+
+    stopwatch watch{};
+    std::uint64_t hooks{};
+    if (before) {
+      before();
+      hooks += watch.lap();
+    }
+    given_step.second(pattern, text, pickle.table(expected_step));
+    const auto duration = watch.lap();
+    if (after) {
+      after();
+      hooks += watch.lap();
+    }
+    profile->record(name, pattern, *given_step.first.file ? file : std::string{}, given_step.first.line, duration,
+                    hooks);
+  });
+}
+
+inline void run(const std::string& feature_file, const pickle& pickle, const std::function<void()>& before,
+                const step_definitions_t& definitions, const std::function<void()>& after,
+                const std::shared_ptr<step_registry>& registry) {
+  const auto compiled = registry ? registry->get(definitions) : std::make_shared<const compiled_steps>(definitions);
+  for (const auto& expected_step : pickle.steps()) {
+    run_step(feature_file, *compiled, definitions, pickle, expected_step, before, after);
+  }
+}
+
+struct failure {
+  TestPartResult::Type type{};
+  std::string file{};
+  int line{};
+  std::string message{};
+};
+
+/**
+ * Scenarios merged into a tree of common step prefixes (`--gunit_shared_prefix`)
+ *
+ * Every prefix is executed once and the process is forked at each branch, results of the scenarios are sent back
+ * through pipes and replayed by the tests of the scenarios.
+ */
+class prefix_tree {
+  struct node {
+    std::size_t scenario;  // of the step
+    std::size_t step;
+    std::vector<std::size_t> children{};
+    std::vector<std::size_t> scenarios{};  // ending at the node
+  };
+
+  struct result {
+    bool ran{};
+    recording_reporter output{};
+    std::vector<failure> failures{};
+  };
+
+ public:
+  explicit prefix_tree(std::vector<std::shared_ptr<const pickle>> pickles)
+      : pickles_{std::move(pickles)}, results_(pickles_.size()) {
+    for (auto i = 0u; i < pickles_.size(); ++i) {
+      auto current = std::size_t{};
+      const auto& steps = pickles_[i]->steps();
+      for (auto s = 0u; s < steps.size(); ++s) {
+        const auto& children = nodes_[current].children;
+        const auto child = std::find_if(children.begin(), children.end(), [&](std::size_t c) {
+          const auto& prefix = *pickles_[nodes_[c].scenario];
+          return prefix.same(prefix.steps()[nodes_[c].step], *pickles_[i], steps[s]);
+        });
+        if (child != children.end()) {
+          current = *child;
+        } else {
+          nodes_[current].children.push_back(nodes_.size());
+          current = nodes_.size();
+          nodes_.push_back({i, s, {}, {}});
         }
-        given_step.second.second(text, make_table(expected_step));
-        if (after) {
-          after();
+      }
+      nodes_[current].scenarios.push_back(i);
+    }
+  }
+
+  bool done() const { return done_; }
+
+  void run(const std::string& feature_file, const std::function<void()>& before, const step_definitions_t& definitions,
+           const std::function<void()>& after, const std::shared_ptr<step_registry>& registry) {
+    const auto compiled = registry ? registry->get(definitions) : std::make_shared<const compiled_steps>(definitions);
+    recording_reporter output{};
+    TestPartResultArray failures{};
+    std::string out{};
+    {
+      const scoped_reporter scoped{output};
+      const ScopedFakeTestPartResultReporter intercept{ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD,
+                                                       &failures};
+      const context ctx{feature_file, *compiled, definitions, before, after, output, failures};
+      explore(ctx, 0, [&](const std::string& result) { out += result; });
+    }
+
+    string_view in{out};
+    std::uint64_t scenario{};
+    while (deserialize(in, scenario) && scenario < results_.size() && load(in, results_[scenario])) {
+      results_[scenario].ran = true;
+    }
+    done_ = true;
+  }
+
+  /**
+   * Reports output and failures of the scenario
+   */
+  void replay(std::size_t scenario) const {
+    const auto& result = results_[scenario];
+    if (not result.ran) {
+      ADD_FAILURE() << "Scenario hasn't been run!";
+      return;
+    }
+    result.output.replay(GetReporter());
+    for (const auto& f : result.failures) {
+      internal::AssertHelper(f.type, f.file.empty() ? nullptr : f.file.c_str(), f.line, f.message.c_str()) = Message();
+    }
+  }
+
+ private:
+  struct context {
+    const std::string& feature_file;
+    const compiled_steps& compiled;
+    const step_definitions_t& definitions;
+    const std::function<void()>& before;
+    const std::function<void()>& after;
+    const recording_reporter& output;
+    const TestPartResultArray& failures;
+  };
+
+  using write_t = std::function<void(const std::string&)>;
+
+  void explore(const context& ctx, std::size_t n, const write_t& write) const {
+    const auto& current = nodes_[n];
+    if (n) {
+      try {
+        const auto& pickle = *pickles_[current.scenario];
+        run_step(ctx.feature_file, ctx.compiled, ctx.definitions, pickle, pickle.steps()[current.step], ctx.before,
+                 ctx.after);
+      } catch (const std::exception& e) {
+        return snapshot(ctx, n, "C++ exception with description \"" + std::string{e.what()} + "\" thrown in the test body.",
+                        {}, write);
+      } catch (...) {
+        return snapshot(ctx, n, "Unknown C++ exception thrown in the test body.", {}, write);
+      }
+    }
+
+    for (const auto scenario : current.scenarios) {
+      std::string out{};
+      save(out, ctx, scenario, {});
+      write(out);
+    }
+    for (auto i = 0u; i < current.children.size(); ++i) {
+      const auto child = current.children[i];
+      if (i + 1 == current.children.size()) {
+        explore(ctx, child, write);
+        continue;
+      }
+
+      const auto run = [&](const write_t& write) { explore(ctx, child, write); };
+      reporter()->Flush();  // only the forking thread survives in the child, the writer thread mustn't be running
+      const auto forked = get_timeouts().step ? run_forked_with_deadlines(run) : run_forked(run);
+      string_view in{forked.out};
+      auto complete = in.data();
+      std::vector<std::size_t> reported{};
+      std::uint64_t scenario{};
+      result r{};
+      while (deserialize(in, scenario) && load(in, r)) {
+        reported.push_back(scenario);
+        complete = in.data();
+      }
+      write({forked.out.data(), complete});
+      if (not forked.exited) {
+        snapshot(ctx, child, "Scenario " + forked.status, reported, write);
+      }
+    }
+  }
+
+  /**
+   * Writes results of the scenarios of the subtree, which haven't been reported yet, in the current state with the failure
+   */
+  void snapshot(const context& ctx, std::size_t n, const std::string& message, const std::vector<std::size_t>& reported,
+                const write_t& write) const {
+    std::vector<std::size_t> nodes{n};
+    while (not nodes.empty()) {
+      const auto& current = nodes_[nodes.back()];
+      nodes.pop_back();
+      for (const auto scenario : current.scenarios) {
+        if (std::find(reported.begin(), reported.end(), scenario) == reported.end()) {
+          std::string out{};
+          save(out, ctx, scenario, message);
+          write(out);
         }
-        found = true;
       }
+      nodes.insert(nodes.end(), current.children.begin(), current.children.end());
     }
+  }
 
-    if (not found) {
-      throw StepIsNotImplemented{"STEP \"" + text + "\" not implemented!"};
+  static void save(std::string& out, const context& ctx, std::size_t scenario, const std::string& message) {
+    serialize(out, std::uint64_t(scenario));
+    auto output = ctx.output;
+    output.OnScenarioEnd();
+    output.save(out);
+    serialize(out, std::uint64_t(ctx.failures.size() + not message.empty()));
+    for (auto i = 0; i < ctx.failures.size(); ++i) {
+      const auto& f = ctx.failures.GetTestPartResult(i);
+      serialize(out, f.type());
+      serialize(out, std::string{f.file_name() ? f.file_name() : ""});
+      serialize(out, f.line_number());
+      serialize(out, std::string{f.message()});
+    }
+    if (not message.empty()) {
+      serialize(out, TestPartResult::kNonFatalFailure);
+      serialize(out, std::string{});
+      serialize(out, -1);
+      serialize(out, message);
     }
   }
-}
+
+  static bool load(string_view& in, result& r) {
+    std::uint64_t size{};
+    if (not r.output.load(in) || not deserialize(in, size)) {
+      return false;
+    }
+    r.failures.resize(size);
+    for (auto& f : r.failures) {
+      if (not deserialize(in, f.type) || not deserialize(in, f.file) || not deserialize(in, f.line) ||
+          not deserialize(in, f.message)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::shared_ptr<const pickle>> pickles_{};
+  std::vector<node> nodes_ = std::vector<node>(1);
+  std::vector<result> results_{};
+  bool done_{};
+};
 
 template <class TSteps, class T, class... Ts>
-inline auto call_steps(const TSteps& steps, const std::string& pickles, const std::string& file, detail::type_list<T, Ts...>) {
-  return steps(T{file, pickles}, Ts{}...);
+inline auto call_steps(const TSteps& steps, const std::shared_ptr<const pickle>& pickle, const std::string& file,
+                       const std::shared_ptr<step_registry>& registry, const std::shared_ptr<prefix_tree>& tree,
+                       detail::type_list<T, Ts...>) {
+  return steps(T{file, pickle, registry, tree}, Ts{}...);
 }
 
 inline std::pair<bool, std::string> make_tags(const nlohmann::json& tags) {
@@ -170,56 +897,648 @@ inline std::pair<bool, std::string> make_tags(const nlohmann::json& tags) {
   return {disabled, result};
 }
 
-template <class TSteps>
-inline void parse_and_register(const std::string& name, const TSteps& steps, const std::string& feature) {
-  const auto content = read_file(feature);
-  gherkin::parser parser{L"en"};
-  gherkin::compiler compiler{feature};
-  const auto gherkin_document = parser.parse(content);
+struct feature_header {
+  std::string name{};
+  std::vector<std::string> tags{};
+  std::string language{"en"};
+};
+
+/**
+ * @return name, tags and language (`# language: fr`) of the feature read from the UTF-8 content without parsing it
+ */
+inline feature_header read_feature_header(string_view content) {
+  feature_header header{};
+  if (content.substr(0, 3) == "\xEF\xBB\xBF") {
+    content = content.substr(3);
+  }
+  while (not content.empty()) {
+    const auto eol = std::find(content.begin(), content.end(), '\n');
+    std::string line{content.begin(), eol};
+    content = content.substr(std::min(std::size_t(eol - content.begin()) + 1, content.size()));
+    trim(line);
+    if (not line.empty() && line[0] == '@') {
+      const auto space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+      for (auto it = line.begin(); it != line.end() && *it != '#';) {
+        const auto end = std::find_if(it, line.end(), [&](char c) { return space(c) || c == '#'; });
+        header.tags.emplace_back(it, end);
+        it = std::find_if_not(end, line.end(), space);
+      }
+    } else if (not line.empty() && line[0] == '#') {
+      line.erase(0, 1);
+      trim(line);
+      if (line.compare(0, 9, "language:") == 0) {
+        line.erase(0, 9);
+        trim(line);
+        header.language = line;
+      }
+    } else if (not line.empty()) {
+      const auto colon = line.find(':');
+      if (colon == std::string::npos) {
+        return {};
+      }
+      line.erase(0, colon + 1);
+      trim(line);
+      header.name = line;
+      return header;
+    }
+  }
+  return {};
+}
+
+struct scenario {
+  std::string name{};
+  std::pair<bool, std::string> tags{};
+  std::vector<std::string> tag_names{};  // including the inherited feature tags
+  std::shared_ptr<const detail::pickle> pickle{};
+  int line{};
+  int outline{};  // line of the scenario outline for examples, 0 otherwise
+};
+
+/**
+ * Compiled feature file, (de)serialized by the features cache
+ */
+struct feature {
+  static constexpr std::uint64_t VERSION = 3;
+
+  std::string name{};
+  std::vector<scenario> scenarios{};
+
+  void save(std::string& out) const {
+    serialize(out, name);
+    serialize(out, std::uint64_t(scenarios.size()));
+    for (const auto& s : scenarios) {
+      serialize(out, s.name);
+      serialize(out, s.tags.first);
+      serialize(out, s.tags.second);
+      serialize(out, s.tag_names);
+      serialize(out, s.line);
+      serialize(out, s.outline);
+      s.pickle->save(out);
+    }
+  }
+
+  static bool load(string_view in, feature& f) {
+    std::uint64_t size{};
+    if (not in.data() || not deserialize(in, f.name) || not deserialize(in, size)) {
+      return false;
+    }
+    f.scenarios.resize(size);
+    for (auto& s : f.scenarios) {
+      auto p = std::make_shared<detail::pickle>();
+      if (not deserialize(in, s.name) || not deserialize(in, s.tags.first) || not deserialize(in, s.tags.second) ||
+          not deserialize(in, s.tag_names) || not deserialize(in, s.line) || not deserialize(in, s.outline) ||
+          not pickle::load(in, *p)) {
+        return false;
+      }
+      s.pickle = std::move(p);
+    }
+    return true;
+  }
+};
+
+/**
+ * @return parser of the language reused by the features compiled on the current thread
+ */
+inline gherkin::parser& parser(const std::string& language) {
+  static thread_local std::unordered_map<std::string, std::unique_ptr<gherkin::parser>> parsers{};
+  auto& parser = parsers[language];
+  if (not parser) {
+    parser = std::make_unique<gherkin::parser>(std::wstring(language.begin(), language.end()));
+  }
+  return *parser;
+}
+
+/**
+ * Compiles the UTF-8 content of the feature, the name of the feature is taken from the header
+ */
+inline feature compile(const std::string& path, string_view content, const feature_header& header) {
+  gherkin::compiler compiler{path};
+  const auto gherkin_document = parser(header.language).parse(utf8_decode(content.data(), content.size()));
   const auto pickles = compiler.compile(gherkin_document);
-  const auto ast = nlohmann::json::parse(compiler.ast(gherkin_document));
+  feature result{};
+  if (not pickles.empty()) {
+    result.name = header.name;
+  }
   for (const auto& pickle : pickles) {
-    const std::string feature_name = ast["document"]["feature"]["name"];
-    const auto pickle_json = nlohmann::json::parse(pickle)["pickle"];
-    const std::string scenario_name = pickle_json["name"];
-    const auto tags = make_tags(pickle_json["tags"]);
-    const auto disabled = tags.first ? "DISABLED_" : "";
-
-    if (PatternMatchesString(name.c_str(), feature_name.c_str())) {
-      class TestFactory : public internal::TestFactoryBase {
-        class test : public Test {
-         public:
-          test(const TSteps& steps, const std::string& pickles, const std::string& file)
-              : steps{steps}, pickles{pickles}, file{file} {}
-
-          void TestBody() {
-            static_assert(
-                std::is_same<Steps, decltype(call_steps(steps, pickles, file, detail::function_args_t<TSteps, Steps>{}))>{},
-                "STEPS implementation has to return testing::Steps type!");
-            call_steps(steps, pickles, file, detail::function_args_t<TSteps, Steps>{});
-            std::cout << '\n';
-          }
+    const auto json = nlohmann::json::parse(pickle)["pickle"];
+    const auto& locations = json["locations"];
+    std::vector<std::string> tag_names{};
+    for (const auto& tag : json["tags"]) {
+      tag_names.push_back(tag["name"]);
+    }
+    result.scenarios.push_back({json["name"], make_tags(json["tags"]), std::move(tag_names),
+                                std::make_shared<const detail::pickle>(json), locations.front()["line"].get<int>(),
+                                locations.size() > 1 ? locations.back()["line"].get<int>() : 0});
+  }
+  return result;
+}
+
+inline feature compile(const std::string& path, string_view content) {
+  return compile(path, content, read_feature_header(content));
+}
+
+/**
+ * Compiled features cache enabled by `--gunit_features_cache[=path]` (.gunit/features.bin by default)
+ */
+inline file_cache* features_cache() {
+  static const auto cache = [] {
+    const auto path = GetFlag("features_cache", {}, ".gunit/features.bin");
+    const std::uint64_t version = feature::VERSION;
+    return path.empty() ? std::unique_ptr<file_cache>{} : std::make_unique<file_cache>(path, version);
+  }();
+  return cache.get();
+}
+
+/**
+ * Scenarios selected by `--gunit_tags="@smoke and not @slow"`, all of them by default
+ */
+inline const tag_expression& tags_filter() {
+  static const tag_expression expression{GetFlag("tags")};
+  return expression;
+}
+
+/**
+ * @return compiled feature or nullptr if the feature doesn't match the STEPS name, the filter or the tags filter
+ */
+inline std::unique_ptr<feature> load_feature(const std::string& name, const std::string& path, const filter& f) {
+  const auto skip = [&](const std::string& header) {
+    return not header.empty() && (not PatternMatchesString(name.c_str(), header.c_str()) ||
+                                  not(f.matches_prefix(header) || f.matches_prefix("DISABLED_" + header)));
+  };
+
+  auto compiled = std::make_unique<feature>();
+  const auto cache = features_cache();
+  if (not cache || not feature::load(cache->get(path), *compiled)) {
+    const mapped_file file{path};
+    if (not file.is_open()) {
+      throw std::runtime_error("File \"" + path + "\" not found!");
+    }
+    const auto header = read_feature_header({file.data(), file.size()});
+    if (skip(header.name) || not tags_filter().may_match(header.tags)) {
+      return {};
+    }
+    *compiled = compile(path, {file.data(), file.size()}, header);
+    if (cache) {
+      std::string out{};
+      compiled->save(out);
+      cache->put(path, out);
+    }
+  } else if (skip(compiled->name)) {
+    return {};
+  }
+  return compiled;
+}
+
+/**
+ * @return number of threads reading the features (`--gunit_parse_threads=N`, all hardware threads by default)
+ */
+inline std::size_t parse_threads() { return std::stoul(GetFlag("parse_threads", std::to_string(hardware_threads()))); }
+
+/**
+ * @return entries of the directory, cached with its modification time in the features cache
+ */
+inline directory_entries list_directory(const std::string& path, file_cache* cache) {
+  const auto mtime = modification_time(path);
+  directory_entries entries{};
+  if (cache) {
+    auto in = cache->get(path);
+    std::uint64_t cached{};
+    if (in.data() && deserialize(in, cached) && cached == mtime && deserialize(in, entries.files) &&
+        deserialize(in, entries.directories)) {
+      return entries;
+    }
+  }
+  entries = read_directory(path);
+  if (cache) {
+    std::string out{};
+    serialize(out, mtime);
+    serialize(out, entries.files);
+    serialize(out, entries.directories);
+    cache->put(path, out);
+  }
+  return entries;
+}
 
-         private:
-          TSteps steps;
-          std::string pickles;
-          std::string file;
-        };
+/**
+ * @return files under the root up to `depth` levels of subdirectories, directories of a level are listed in parallel
+ */
+inline std::vector<std::string> walk(const std::string& root, std::size_t depth, file_cache* cache, std::size_t threads) {
+  const auto join = [](const std::string& directory, const std::string& name) {
+    return directory.empty() ? name : directory.back() == '/' ? directory + name : directory + '/' + name;
+  };
+  std::vector<std::string> files{}, level{root};
+  for (std::size_t i = 0; not level.empty() && i <= depth; ++i) {
+    std::vector<directory_entries> entries(level.size());
+    parallel_for(level.size(), [&](std::size_t j) { entries[j] = list_directory(level[j].empty() ? "." : level[j], cache); },
+                 threads);
+    std::vector<std::string> next{};
+    for (auto j = 0u; j < level.size(); ++j) {
+      for (const auto& file : entries[j].files) {
+        files.push_back(join(level[j], file));
+      }
+      for (const auto& directory : entries[j].directories) {
+        next.push_back(join(level[j], directory));
+      }
+    }
+    level = std::move(next);
+  }
+  return files;
+}
+
+/**
+ * Expands `SCENARIO` entries, directories are searched for `*.feature` files recursively and globs (`*`, `?`, `**`) are
+ * matched against the walked paths, other entries are kept as they are
+ *
+ * @return feature files, each of them once, matches of an entry are sorted
+ */
+inline std::vector<std::string> find_features(const std::vector<std::string>& entries, file_cache* cache,
+                                              std::size_t threads) {
+  std::vector<std::string> features{};
+  std::unordered_set<std::string> found{};
+  const auto add = [&](const std::string& feature) {
+    if (found.insert(feature).second) {
+      features.push_back(feature);
+    }
+  };
+
+  for (auto glob : entries) {
+    if (glob.find_first_of("*?") == std::string::npos) {
+      if (not is_directory(glob)) {
+        add(glob);
+        continue;
+      }
+      while (glob.size() > 1 && glob.back() == '/') {
+        glob.pop_back();
+      }
+      glob += glob == "/" ? "**/*.feature" : "/**/*.feature";
+    }
+    const auto slash = glob.rfind('/', glob.find_first_of("*?"));
+    const auto root = slash == std::string::npos ? std::string{} : glob.substr(0, slash ? slash : 1);
+    const auto pattern = glob.substr(slash == std::string::npos ? 0 : slash + 1);
+    const auto depth = pattern.find("**") == std::string::npos
+                           ? std::size_t(std::count(pattern.begin(), pattern.end(), '/'))
+                           : std::numeric_limits<std::size_t>::max();
+    auto files = walk(root, depth, cache, threads);
+    std::sort(files.begin(), files.end());
+    for (const auto& file : files) {
+      if (GlobMatchesPath(glob, file)) {
+        add(file);
+      }
+    }
+  }
+  return features;
+}
+
+/**
+ * @return feature files of the `SCENARIO` entries (files, directories and globs separated with ':')
+ */
+inline const std::vector<std::string>& feature_files(const std::string& scenario) {
+  static std::unordered_map<std::string, std::vector<std::string>> files{};
+  auto it = files.find(scenario);
+  if (it == files.end()) {
+    it = files.emplace(scenario, find_features(split(scenario, ':'), features_cache(), parse_threads())).first;
+  }
+  return it->second;
+}
+
+inline void report_scenario(const std::string& feature, const std::string& file, const scenario& s) {
+  GetReporter().OnScenario(feature, file, s.name, s.line, s.tag_names);
+}
+
+/**
+ * @return deadline of the scenario (`--gunit_scenario_timeout=ms`), steps sharing a prefix are limited per step only
+ */
+inline deadline scenario_deadline(const scenario& s) {
+  const auto timeout = get_timeouts().scenario;
+  return timeout ? deadline{timeout, "Scenario \"" + s.name + "\""} : deadline{};
+}
 
+/**
+ * @return number of threads running the examples of a scenario outline (`--gunit_parallel_examples[=N]`, all hardware
+ *         threads when N isn't given), 0 when examples are registered as separate tests
+ */
+inline std::size_t parallel_examples() {
+  const auto threads = GetFlag("parallel_examples", {}, std::to_string(hardware_threads()));
+  return threads.empty() ? 0 : std::stoul(threads);
+}
+
+/**
+ * Runs the examples on a worker pool, each example with its own Steps
+ *
+ * Output and failures of the examples are recorded per thread and replayed in the order of the examples.
+ */
+template <class TSteps>
+inline void run_examples(const TSteps& steps, const std::vector<scenario>& examples, const std::string& feature,
+                         const std::string& file, const std::shared_ptr<step_registry>& registry, std::size_t threads) {
+  struct result {
+    recording_reporter reporter{};
+    TestPartResultArray failures{};
+  };
+
+  std::vector<result> results(examples.size());
+  parallel_for(examples.size(),
+               [&](std::size_t i) {
+                 const scoped_reporter reporter{results[i].reporter};
+                 const ScopedFakeTestPartResultReporter failures{
+                     ScopedFakeTestPartResultReporter::INTERCEPT_ONLY_CURRENT_THREAD, &results[i].failures};
+                 report_scenario(feature, file, examples[i]);
+                 const auto timeout = scenario_deadline(examples[i]);
+                 try {
+                   call_steps(steps, examples[i].pickle, file, registry, {}, detail::function_args_t<TSteps, Steps>{});
+                 } catch (const std::exception& e) {
+                   ADD_FAILURE() << "C++ exception with description \"" << e.what() << "\" thrown in the test body.";
+                 } catch (...) {
+                   ADD_FAILURE() << "Unknown C++ exception thrown in the test body.";
+                 }
+                 GetReporter().OnScenarioEnd();
+               },
+               threads);
+
+  for (auto i = 0u; i < results.size(); ++i) {
+    results[i].reporter.replay(GetReporter());
+    SCOPED_TRACE("Example at line " + std::to_string(examples[i].line));
+    const auto& failures = results[i].failures;
+    for (auto j = 0; j < failures.size(); ++j) {
+      const auto& failure = failures.GetTestPartResult(j);
+      internal::AssertHelper(failure.type(), failure.file_name(), failure.line_number(), failure.message()) = Message();
+    }
+  }
+}
+
+/**
+ * State shared by the tests of a feature
+ */
+struct feature_context {
+  std::string name{};
+  std::string file{};
+  std::shared_ptr<step_registry> registry{};
+  std::shared_ptr<prefix_tree> tree{};
+  std::size_t threads{};
+};
+
+template <class TSteps>
+inline void register_feature(const std::string& name, const TSteps& steps, const std::string& feature,
+                             const detail::feature& compiled, const filter& f,
+                             const std::shared_ptr<step_registry>& registry) {
+  const auto& feature_name = compiled.name;
+  if (not PatternMatchesString(name.c_str(), feature_name.c_str())) {
+    return;
+  }
+
+  const auto shared_prefix = GetBoolFlag("shared_prefix");
+  const auto context = std::make_shared<feature_context>();
+  context->name = feature_name;
+  context->file = feature;
+  context->registry = registry;
+  context->threads = shared_prefix ? 0 : parallel_examples();
+
+  std::vector<std::vector<scenario>> tests{};
+  for (const auto& scenario : compiled.scenarios) {
+    const auto disabled = scenario.tags.first ? "DISABLED_" : "";
+    if (not tags_filter().matches(scenario.tag_names) ||
+        not f.matches(disabled + feature_name + scenario.tags.second + "." + scenario.name)) {
+      continue;
+    }
+    if (context->threads && scenario.outline && not tests.empty() && tests.back().front().outline == scenario.outline &&
+        tests.back().front().tags == scenario.tags) {
+      tests.back().push_back(scenario);
+    } else {
+      tests.push_back({scenario});
+    }
+  }
+
+  constexpr auto NOT_SHARED = std::size_t(-1);
+  auto shared = std::size_t{};
+  std::vector<std::shared_ptr<const pickle>> pickles{};
+  if (shared_prefix) {
+    for (const auto& scenarios : tests) {
+      if (not scenarios.front().tags.first) {
+        pickles.push_back(scenarios.front().pickle);
+      }
+    }
+    context->tree = std::make_shared<prefix_tree>(pickles);
+  }
+
+  for (const auto& scenarios : tests) {
+    class TestFactory : public internal::TestFactoryBase {
+      class test : public Test {
        public:
-        TestFactory(const TSteps& steps, const std::string& pickles, const std::string& file)
-            : steps{steps}, pickles{pickles}, file{file} {}
-        Test* CreateTest() override { return new test{steps, pickles, file}; }
+        explicit test(const TestFactory& factory) : factory{factory} {}
+
+        void TestBody() {
+          const auto& steps = factory.steps;
+          const auto& scenarios = factory.scenarios;
+          const auto& context = *factory.context;
+          static_assert(std::is_same<Steps, decltype(call_steps(steps, scenarios.front().pickle, context.file,
+                                                                context.registry, context.tree,
+                                                                detail::function_args_t<TSteps, Steps>{}))>{},
+                        "STEPS implementation has to return testing::Steps type!");
+          if (factory.index != NOT_SHARED) {
+            if (not context.tree->done()) {
+              call_steps(steps, scenarios.front().pickle, context.file, context.registry, context.tree,
+                         detail::function_args_t<TSteps, Steps>{});
+            }
+            report_scenario(context.name, context.file, scenarios.front());
+            context.tree->replay(factory.index);
+          } else if (scenarios.size() == 1) {
+            report_scenario(context.name, context.file, scenarios.front());
+            const auto timeout = scenario_deadline(scenarios.front());
+            call_steps(steps, scenarios.front().pickle, context.file, context.registry, {},
+                       detail::function_args_t<TSteps, Steps>{});
+            GetReporter().OnScenarioEnd();
+          } else {
+            run_examples(steps, scenarios, context.name, context.file, context.registry, context.threads);
+          }
+        }
 
        private:
-        TSteps steps;
-        std::string pickles;
-        std::string file;
+        const TestFactory& factory;
       };
 
-      MakeAndRegisterTestInfo(new TestFactory{steps, pickle, feature}, disabled + feature_name + tags.second, scenario_name,
-                              __FILE__, __LINE__, detail::type<decltype(internal::MakeAndRegisterTestInfo)>{});
+     public:
+      TestFactory(const TSteps& steps, const std::vector<scenario>& scenarios,
+                  const std::shared_ptr<const feature_context>& context, std::size_t index)
+          : steps{steps}, scenarios{scenarios}, context{context}, index{index} {}
+      Test* CreateTest() override { return new test{*this}; }
+
+     private:
+      TSteps steps;
+      std::vector<scenario> scenarios;
+      std::shared_ptr<const feature_context> context;
+      std::size_t index;  // of the scenario in the prefix tree
+    };
+
+    const auto& scenario = scenarios.front();
+    const auto disabled = scenario.tags.first ? "DISABLED_" : "";
+    const auto index = context->tree && not scenario.tags.first ? shared++ : NOT_SHARED;
+    MakeAndRegisterTestInfo(new TestFactory{steps, scenarios, context, index},
+                            disabled + feature_name + scenario.tags.second, scenario.name, __FILE__, __LINE__,
+                            detail::type<decltype(internal::MakeAndRegisterTestInfo)>{});
+  }
+}
+
+#if defined(__linux__)
+inline bool watch() {
+  static const auto enabled = GetBoolFlag("watch");
+  return enabled;
+}
+
+/**
+ * Features registered with `--gunit_watch` and their callbacks run when the feature file is written
+ */
+inline std::vector<std::pair<std::string, std::function<void()>>>& watched_features() {
+  static std::vector<std::pair<std::string, std::function<void()>>> features{};
+  return features;
+}
+
+/**
+ * Waits for the watched features to be written, never returns when there are any
+ */
+inline void watch_features() {
+  if (watched_features().empty()) {
+    return;
+  }
+  std::vector<std::string> paths{};
+  for (const auto& feature : watched_features()) {
+    paths.push_back(feature.first);
+  }
+  file_watcher watcher{paths};
+  for (;;) {
+    std::printf("[  WATCH   ] Waiting for changes of %zu feature file(s)...\n", paths.size());
+    std::fflush(stdout);
+    for (const auto& path : watcher.wait()) {
+      for (const auto& feature : watched_features()) {
+        if (feature.first == path) {
+          feature.second();
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Runs a scenario outside of gtest, failures are printed in the gtest format
+ */
+template <class TSteps>
+inline void run_watched(const TSteps& steps, const scenario& s, const std::string& test, const std::string& file,
+                        const std::shared_ptr<step_registry>& registry) {
+  std::printf("[ RUN      ] %s\n", test.c_str());
+  std::fflush(stdout);
+  TestPartResultArray results{};
+  {
+    const ScopedFakeTestPartResultReporter failures{ScopedFakeTestPartResultReporter::INTERCEPT_ALL_THREADS, &results};
+    const auto timeout = scenario_deadline(s);
+    try {
+      call_steps(steps, s.pickle, file, registry, {}, detail::function_args_t<TSteps, Steps>{});
+    } catch (const std::exception& e) {
+      ADD_FAILURE() << "C++ exception with description \"" << e.what() << "\" thrown in the test body.";
+    } catch (...) {
+      ADD_FAILURE() << "Unknown C++ exception thrown in the test body.";
     }
+    GetReporter().OnScenarioEnd();
+  }
+  GetReporter().Flush();
+
+  auto failed = false;
+  for (auto i = 0; i < results.size(); ++i) {
+    const auto& result = results.GetTestPartResult(i);
+    failed |= result.failed();
+    std::printf("%s %s\n%s\n", internal::FormatFileLocation(result.file_name(), result.line_number()).c_str(),
+                result.failed() ? "Failure" : "Success", result.message());
+  }
+  std::printf(failed ? "[  FAILED  ] %s\n" : "[       OK ] %s\n", test.c_str());
+  std::fflush(stdout);
+}
+
+/**
+ * Watches the feature file (`--gunit_watch`, Linux only), when it's written the feature is parsed again and only
+ * the selected scenarios which are new or have changed steps are run
+ */
+template <class TSteps>
+inline void watch_feature(const std::string& name, const TSteps& steps, const std::string& feature, const filter& f,
+                          const detail::feature& compiled, const std::shared_ptr<step_registry>& registry) {
+  using hashes_t = std::unordered_map<std::string, std::vector<std::uint64_t>>;
+  const auto select = [name, f](const detail::feature& compiled) {
+    std::vector<std::pair<std::string, const scenario*>> selected{};
+    if (PatternMatchesString(name.c_str(), compiled.name.c_str())) {
+      for (const auto& scenario : compiled.scenarios) {
+        const auto test = compiled.name + scenario.tags.second + "." + scenario.name;
+        if (not scenario.tags.first && tags_filter().matches(scenario.tag_names) && f.matches(test)) {
+          selected.emplace_back(test, &scenario);
+        }
+      }
+    }
+    return selected;
+  };
+
+  const auto previous = std::make_shared<hashes_t>();
+  for (const auto& scenario : select(compiled)) {
+    (*previous)[scenario.first].push_back(scenario.second->pickle->hash());
+  }
+
+  watched_features().emplace_back(feature, [=] {
+    detail::feature current{};
+    try {
+      const mapped_file file{feature};
+      if (not file.is_open()) {
+        throw std::runtime_error("File \"" + feature + "\" not found!");
+      }
+      current = compile(feature, {file.data(), file.size()});
+    } catch (const std::exception& e) {
+      std::printf("[  ERROR   ] %s: %s\n", feature.c_str(), e.what());
+      return;
+    }
+
+    hashes_t hashes{};
+    for (const auto& scenario : select(current)) {
+      const auto hash = scenario.second->pickle->hash();
+      hashes[scenario.first].push_back(hash);
+      const auto it = previous->find(scenario.first);
+      if (it == previous->end() || std::find(it->second.begin(), it->second.end(), hash) == it->second.end()) {
+        run_watched(steps, *scenario.second, scenario.first, feature, registry);
+      }
+    }
+    *previous = std::move(hashes);
+  });
+}
+#endif
+
+template <class TSteps>
+inline void parse_and_register(const std::string& name, const TSteps& steps, const std::string& feature,
+                               const filter& f = filter{},
+                               const std::shared_ptr<step_registry>& registry = std::make_shared<step_registry>()) {
+  const auto compiled = load_feature(name, feature, f);
+  if (compiled) {
+    register_feature(name, steps, feature, *compiled, f, registry);
+#if defined(__linux__)
+    if (watch()) {
+      watch_feature(name, steps, feature, f, *compiled, registry);
+    }
+#endif
+  }
+}
+
+/**
+ * Features are read and compiled concurrently (`--gunit_parse_threads=N`), tests are registered in order
+ */
+template <class TSteps>
+inline void parse_and_register(const std::string& name, const TSteps& steps, const std::vector<std::string>& features,
+                               const filter& f, const std::shared_ptr<step_registry>& registry) {
+  std::vector<std::unique_ptr<feature>> compiled(features.size());
+  parallel_for(features.size(), [&](std::size_t i) { compiled[i] = load_feature(name, features[i], f); },
+               parse_threads());
+  for (auto i = 0u; i < features.size(); ++i) {
+    if (compiled[i]) {
+      register_feature(name, steps, features[i], *compiled[i], f, registry);
+#if defined(__linux__)
+      if (watch()) {
+        watch_feature(name, steps, features[i], f, *compiled[i], registry);
+      }
+#endif
+    }
+  }
+  if (features_cache()) {
+    features_cache()->save();
   }
 }
 
@@ -227,94 +1546,140 @@ template <class TFeature>
 struct steps {
   template <class TSteps>
   steps(const TSteps& s) {
-    const auto scenario = std::getenv("SCENARIO");
-    if (scenario) {
-      for (const auto& feature : detail::split(scenario, ':')) {
-        parse_and_register(TFeature::c_str(), s, feature);
-      }
-    }
+    static const TSteps steps_{s};
+    static registration registration_{[](const filter& f) {
+                                        const auto scenario = std::getenv("SCENARIO");
+                                        profiler();  // listening before the first test, steps may run forked
+                                        if (scenario) {
+                                          parse_and_register(TFeature::c_str(), steps_, feature_files(scenario), f,
+                                                             std::make_shared<step_registry>());
+                                        }
+                                      },
+                                      nullptr};
+    static const auto registered = (lazy_registry::add(registration_), true);
+    (void)registered;
   }
 };
 
 template <class T>
-inline auto lexical_table_cast(const std::string& str, const Table&, detail::identity<T>) {
+inline auto lexical_table_cast(string_view str, const DataTable&, detail::identity<T>) {
   return detail::lexical_cast<T>(str);
 }
-inline auto lexical_table_cast(const std::string&, const Table& table, detail::identity<const Table&>) { return table; }
-inline auto lexical_table_cast(const std::string&, const Table& table, detail::identity<Table>) { return table; }
+inline Table lexical_table_cast(string_view, const DataTable& table, detail::identity<const Table&>) { return table; }
+inline Table lexical_table_cast(string_view, const DataTable& table, detail::identity<Table>) { return table; }
+inline auto lexical_table_cast(string_view, const DataTable& table, detail::identity<const DataTable&>) { return table; }
+inline auto lexical_table_cast(string_view, const DataTable& table, detail::identity<DataTable>) { return table; }
 
 }  // detail
 
+/**
+ * Keeps running after the tests and runs the new or changed scenarios of the written features (`--gunit_watch`,
+ * Linux only), returns right away when no features are watched
+ *
+ * Has to be called after RUN_ALL_TESTS has returned, so that all the listeners have seen the end of the tests.
+ */
+inline void WatchFeatures() {
+#if defined(__linux__)
+  detail::watch_features();
+#endif
+}
+
+/**
+ * Step definitions of a scenario
+ */
 class Steps {
  public:
-  explicit Steps(const std::string& file, const std::string& scenario) : file_{file}, scenario_{scenario} {}
+  explicit Steps(const std::string& file, const std::string& scenario)
+      : file_{file},
+        pickle_{scenario.empty() ? nullptr
+                                 : std::make_shared<const detail::pickle>(nlohmann::json::parse(scenario)["pickle"])} {}
+
+  template <class TPickle>
+  explicit Steps(const std::string& file, const std::shared_ptr<const TPickle>& pickle,
+                 const std::shared_ptr<detail::step_registry>& registry = {},
+                 const std::shared_ptr<detail::prefix_tree>& tree = {})
+      : file_{file}, pickle_{pickle}, registry_{registry}, tree_{tree} {}
 
-  Steps(const Steps& steps) { detail::run(steps.file_, steps.scenario_, steps.before_, steps.steps_, steps.after_); }
+  /**
+   * Runs the scenario with the steps
+   *
+   * @throws std::invalid_argument when the steps have been created without a scenario
+   */
+  Steps(const Steps& steps) {
+    if (not steps.tree_ && not steps.pickle_) {
+      throw std::invalid_argument{"Steps without a scenario can't be run!"};
+    }
+    if (steps.tree_) {
+      steps.tree_->run(steps.file_, steps.before_, steps.steps_, steps.after_, steps.registry_);
+    } else {
+      detail::run(steps.file_, *steps.pickle_, steps.before_, steps.steps_, steps.after_, steps.registry_);
+    }
+  }
 
   template <class File = detail::string<>, int line = 0, class TPattern>
   auto Given(const TPattern& pattern) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size>{{"Given", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, false, TPattern>{{"Given", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0, class TPattern, class T>
   auto Given(const TPattern& pattern, const T&) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size, true>{{"Given", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, true, TPattern>{{"Given", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0>
   auto Given(const char* pattern) {
-    return step<>{{"Given", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<>{{"Given", File::c_str(), line}, add(pattern)};
   }
 
   template <class File = detail::string<>, int line = 0, class T>
   auto Given(const char* pattern, const T&) {
-    return step<-1, true>{{"Given", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<-1, true>{{"Given", File::c_str(), line}, add(pattern)};
   }
 
   template <class File = detail::string<>, int line = 0, class TPattern>
   auto When(const TPattern& pattern) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size>{{"When", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, false, TPattern>{{"When", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0, class TPattern, class T>
   auto When(const TPattern& pattern, const T&) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size, true>{{"When", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, true, TPattern>{{"When", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0>
   auto When(const char* pattern) {
-    return step<>{{"When", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<>{{"When", File::c_str(), line}, add(pattern)};
   }
 
   template <class File = detail::string<>, int line = 0, class T>
   auto When(const char* pattern, const T&) {
-    return step<-1, true>{{"When", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<-1, true>{{"When", File::c_str(), line}, add(pattern)};
   }
 
   template <class File = detail::string<>, int line = 0, class TPattern>
   auto Then(const TPattern& pattern) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size>{{"Then", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, false, TPattern>{{"Then", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0, class TPattern, class T>
   auto Then(const TPattern& pattern, const T&) {
     constexpr auto size = detail::args_size(TPattern{});
-    return step<size, true>{{"Then", File::c_str(), line}, pattern.c_str(), steps_[pattern.c_str()]};
+    return step<size, true, TPattern>{{"Then", File::c_str(), line}, add(pattern.c_str(), detail::is_expression<TPattern>{}, true)};
   }
 
   template <class File = detail::string<>, int line = 0>
   auto Then(const char* pattern) {
-    return step<>{{"Then", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<>{{"Then", File::c_str(), line}, add(pattern)};
   }
 
   template <class File = detail::string<>, int line = 0, class T>
   auto Then(const char* pattern, const T&) {
-    return step<-1, true>{{"Then", File::c_str(), line}, pattern, steps_[pattern]};
+    return step<-1, true>{{"Then", File::c_str(), line}, add(pattern)};
   }
 
   auto Before() { return around{before_}; }
@@ -334,15 +1699,14 @@ class Steps {
     std::function<void()>& expr_;
   };
 
-  template <int ArgsSize = -1, bool HasTable = false>
+  template <int ArgsSize = -1, bool HasTable = false, class TPattern = void>
   class step {
    public:
-    step(const detail::step_info& step_info, const std::string& pattern, detail::step_info_call_step_t& expr)
-        : step_info_(step_info), pattern_{pattern}, expr_{expr} {}
+    step(const detail::step_info& step_info, detail::step_info_call_step_t& expr) : step_info_(step_info), expr_{expr} {}
 
     template <class TExpr>
     void operator=(const TExpr& expr) {
-      expr_ = {step_info_, [ pattern = pattern_, expr ](const std::string& step, const Table& table){
+      expr_ = {step_info_, [expr](const char* pattern, const std::string& step, const DataTable& table){
                                call(expr, step, table, pattern, detail::function_traits_t<TExpr>{});
     }
   };
@@ -350,36 +1714,65 @@ class Steps {
 
 private : template <class TExpr, class... Ts>
           static void
-          call(const TExpr& expr, const std::string& step, const Table& table, const std::string& pattern,
+          call(const TExpr& expr, const std::string& step, const DataTable& table, const char* pattern,
                detail::type_list<Ts...> t) {
   static_assert(ArgsSize == -1 || ArgsSize + int(HasTable) == sizeof...(Ts),
                 "The number of function parameters don't match the number of arguments specified in the pattern!");
-  assert(detail::args_size(pattern) + int(HasTable) == sizeof...(Ts));
-  call_impl(expr, detail::matches(pattern, step), table, t, std::make_index_sequence<sizeof...(Ts)>{},
-            std::integral_constant<bool, HasTable>{});
+  assert(detail::args_size(detail::string_view{pattern}) + int(HasTable) == sizeof...(Ts));
+  call_impl(expr, captures(pattern, step, detail::identity<TPattern>{}), table, t,
+            std::make_index_sequence<sizeof...(Ts)>{}, std::integral_constant<bool, HasTable>{});
+}
+
+static auto captures(const char* pattern, const std::string& step, detail::identity<void>) {
+  return detail::matches(detail::string_view{pattern}, step);
+}
+
+template <class T>
+static auto captures(const char*, const std::string& step, detail::identity<T>) {
+  typename detail::compiled_pattern<T>::captures_t captures{};
+  detail::compiled_pattern<T>::match(step, captures);
+  return captures;
+}
+
+template <char... Chrs>
+static auto captures(const char*, const std::string& step, detail::identity<detail::expression<Chrs...>>) {
+  static const detail::cucumber_expression expression{detail::expression<Chrs...>::c_str()};
+  std::array<detail::string_view, detail::args_size(detail::expression<Chrs...>{})> captures{};
+  expression.match(step, captures.data());
+  return captures;
 }
 
 template <class TExpr, class TMatches, class... Ts, std::size_t... Ns>
-static void call_impl(const TExpr& expr, const TMatches& matches, const Table&, detail::type_list<Ts...>,
+static void call_impl(const TExpr& expr, const TMatches& matches, const DataTable&, detail::type_list<Ts...>,
                       std::index_sequence<Ns...>, std::false_type) {
-  expr(detail::lexical_cast<Ts>(matches[Ns].c_str())...);
+  expr(detail::lexical_cast<Ts>(matches[Ns])...);
 }
 
 template <class TExpr, class TMatches, class... Ts, std::size_t... Ns>
-static void call_impl(const TExpr& expr, const TMatches& matches, const Table& table, detail::type_list<Ts...>,
+static void call_impl(const TExpr& expr, const TMatches& matches, const DataTable& table, detail::type_list<Ts...>,
                       std::index_sequence<Ns...>, std::true_type) {
-  expr(detail::lexical_table_cast(Ns < matches.size() ? matches[Ns].c_str() : "", table, detail::identity<Ts>{})...);
+  expr(detail::lexical_table_cast(Ns < matches.size() ? detail::string_view{matches[Ns]} : detail::string_view{}, table,
+                                  detail::identity<Ts>{})...);
 }
 
 detail::step_info step_info_;
-std::string pattern_;
 detail::step_info_call_step_t& expr_;
 };
 
 private:
+/**
+ * @param literal compile-time pattern, kept by pointer instead of being copied
+ */
+detail::step_info_call_step_t& add(const char* pattern, bool expression = false, bool literal = false) {
+  steps_.push_back({literal ? std::string{} : std::string{pattern}, {}, expression, literal ? pattern : nullptr});
+  return steps_.back().step;
+}
+
 std::string file_;
-std::string scenario_;
-detail::step_info_call_map_t steps_{};
+std::shared_ptr<const detail::pickle> pickle_;
+std::shared_ptr<detail::step_registry> registry_;
+std::shared_ptr<detail::prefix_tree> tree_;
+detail::step_definitions_t steps_{};
 std::function<void()> before_;
 std::function<void()> after_;
 };
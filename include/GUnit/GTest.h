@@ -9,12 +9,19 @@
 
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <cmath>
+#include <functional>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <vector>
+#include "GUnit/Detail/CacheUtils.h"
 #include "GUnit/Detail/Preprocessor.h"
 #include "GUnit/Detail/RegexUtils.h"
+#include "GUnit/Detail/RegistryUtils.h"
+#include "GUnit/Detail/ReportUtils.h"
 #include "GUnit/Detail/StringUtils.h"
-#include "GUnit/Detail/TermUtils.h"
+#include "GUnit/Detail/TimeoutUtils.h"
 #include "GUnit/Detail/TypeTraits.h"
 #include "GUnit/GMake.h"
 #include "GUnit/GMock.h"
@@ -24,44 +31,40 @@ inline namespace v1 {
 namespace detail {
 
 struct TestRun {
-  std::string should_param = GetShouldParam();
+  const filter& should_filter = GetShouldFilter();
   bool next = true;
 
-  std::string GetShouldParam() const {
+  static std::string GetShouldParam() {
     const auto sep = GTEST_FLAG(filter).find(":");
     return sep == std::string::npos ? "*" : GTEST_FLAG(filter).substr(sep + 1);
   }
 
+  static const filter& GetShouldFilter() {
+    static std::string flag{};
+    static filter should{};
+    if (flag != GTEST_FLAG(filter)) {
+      flag = GTEST_FLAG(filter);
+      should = filter{GetShouldParam()};
+    }
+    return should;
+  }
+
   bool run(const std::string& type, const std::string& name, int line, bool disabled = false) {
     if (next) {
       return false;
     }
 
-    const auto result = line > test_line && FilterMatchesShould(name, should_param);
+    const auto result = line > test_line && should_filter.matches(name);
     if (result) {
-      static const bool is_stdout_tty = ShouldUseColor(internal::posix::IsATTY(internal::posix::FileNo(stdout)) != 0);
-      const auto colorize = ShouldUseColor(is_stdout_tty);
-
       if (disabled && !GTEST_FLAG(also_run_disabled_tests)) {
-        if (colorize) {
-          std::cout << "\033[0;33m";
-        }
-        std::cout << "[ DISABLED ] ";
-        if (colorize) {
-          std::cout << "\033[m";  // Resets the terminal to default.
-        }
-        std::cout << name << std::endl;
+        GetReporter().OnShould(type, name, true);
         return false;
       }
 
-      if (colorize) {
-        std::cout << "\033[0;33m";
-      }
-      std::cout << "[ " << std::left << std::setw(8) << type << " ] ";
-      if (colorize) {
-        std::cout << "\033[m";  // Resets the terminal to default.
+      GetReporter().OnShould(type, name, false);
+      if (const auto timeout = get_timeouts().should) {
+        should_deadline = deadline{timeout, type + " \"" + name + "\""};
       }
-      std::cout << name << std::endl;
       test_line = line;
       next = true;
     }
@@ -69,27 +72,164 @@ struct TestRun {
   }
 
   int test_line = 0;
+  deadline should_deadline{};  // until the end of the TearDown of the SHOULD
+};
+
+/**
+ * Random access, on demand generator of parameters
+ *
+ * Values are computed from the index when requested, so that neither registration nor iteration
+ * materializes the parameter space.
+ */
+template <class T>
+class lazy_generator {
+  class iterator : public internal::ParamIteratorInterface<T> {
+   public:
+    iterator(const internal::ParamGeneratorInterface<T>* base, const lazy_generator& generator, std::size_t index)
+        : base_{base}, generator_{generator}, index_{index} {}
+
+    const internal::ParamGeneratorInterface<T>* BaseGenerator() const override { return base_; }
+    void Advance() override {
+      ++index_;
+      value_.reset();
+    }
+    internal::ParamIteratorInterface<T>* Clone() const override { return new iterator{base_, generator_, index_}; }
+    const T* Current() const override {
+      if (not value_) {
+        value_ = std::make_unique<T>(generator_[index_]);
+      }
+      return value_.get();
+    }
+    bool Equals(const internal::ParamIteratorInterface<T>& other) const override {
+      return index_ == static_cast<const iterator&>(other).index_;
+    }
+
+   private:
+    const internal::ParamGeneratorInterface<T>* base_{};
+    lazy_generator generator_;
+    std::size_t index_{};
+    mutable std::unique_ptr<T> value_{};
+  };
+
+  class generator : public internal::ParamGeneratorInterface<T> {
+   public:
+    explicit generator(const lazy_generator& generator) : generator_{generator} {}
+    internal::ParamIteratorInterface<T>* Begin() const override { return new iterator{this, generator_, 0}; }
+    internal::ParamIteratorInterface<T>* End() const override { return new iterator{this, generator_, generator_.size()}; }
+
+   private:
+    lazy_generator generator_;
+  };
+
+ public:
+  using value_type = T;
+
+  lazy_generator(std::size_t size, std::function<T(std::size_t)> at) : size_{size}, at_{std::move(at)} {}
+
+  std::size_t size() const { return size_; }
+  T operator[](std::size_t index) const { return at_(index); }
+
+  /**
+   * Every count-th parameter starting from index, used to spread the parameter space between workers
+   */
+  lazy_generator split(std::size_t index, std::size_t count) const {
+    const auto at = at_;
+    return {index < size_ ? (size_ - index + count - 1) / count : 0, [=](std::size_t i) { return at(index + i * count); }};
+  }
+
+  operator internal::ParamGenerator<T>() const { return internal::ParamGenerator<T>{new generator{*this}}; }
+
+ private:
+  std::size_t size_{};
+  std::function<T(std::size_t)> at_;
+};
+
+template <class T>
+inline auto combine(const lazy_generator<T>& generator) {
+  return lazy_generator<std::tuple<T>>{generator.size(),
+                                       [=](std::size_t index) { return std::make_tuple(generator[index]); }};
+}
+
+template <class T, class... Ts>
+inline auto combine(const lazy_generator<T>& generator, const lazy_generator<Ts>&... generators) {
+  const auto tail = combine(generators...);
+  return lazy_generator<std::tuple<T, Ts...>>{generator.size() * tail.size(), [=](std::size_t index) {
+                                                return std::tuple_cat(std::make_tuple(generator[index / tail.size()]),
+                                                                      tail[index % tail.size()]);
+                                              }};
+}
+
+/**
+ * @return number of values of [begin, end) with the step, as generated by ::testing::Range
+ */
+template <class T>
+inline std::size_t range_size(T begin, T end, T step, std::true_type /*floating point*/) {
+  return begin < end ? static_cast<std::size_t>(std::ceil((end - begin) / step)) : 0;
+}
+
+template <class T>
+inline std::size_t range_size(T begin, T end, T step, std::false_type) {
+  return begin < end ? static_cast<std::size_t>((end - begin + step - 1) / step) : 0;
+}
+
+/**
+ * Runs all parameters of a lazy GTEST as a single test
+ */
+template <class T, class TParam>
+class lazy_param_test : public Test {
+ public:
+  explicit lazy_param_test(const lazy_generator<TParam>& params) : params_{params} {}
+
+  void TestBody() override {
+    const auto worker = std::stoul(GetFlag("params_worker", "0"));
+    const auto workers = std::max(std::stoul(GetFlag("params_workers", "1")), 1ul);
+    if (worker >= workers) {
+      FAIL() << "--gunit_params_worker=" << worker << " has to be less than --gunit_params_workers=" << workers;
+    }
+    const auto params = params_.split(worker, workers);
+    for (auto i = 0u; i < params.size(); ++i) {
+      const auto param = params[i];
+      const auto name = std::to_string(worker + i * workers) + ": " + PrintToString(param);
+      GetReporter().OnShould("PARAM", name, false);
+      SCOPED_TRACE(name);
+      std::unique_ptr<Test> test{internal::ParameterizedTestFactory<T>{param}.CreateTest()};
+      static_cast<T&>(*test).TestBody();
+    }
+  }
+
+ private:
+  lazy_generator<TParam> params_;
+};
+
+template <class T, class TParam>
+class lazy_param_test_factory : public internal::TestFactoryBase {
+ public:
+  explicit lazy_param_test_factory(const lazy_generator<TParam>& params) : params_{params} {}
+  Test* CreateTest() override { return new lazy_param_test<T, TParam>{params_}; }
+
+ private:
+  lazy_generator<TParam> params_;
 };
 
 template <bool DISABLED, class T>
 class GTestAutoRegister {
   static auto IsDisabled(bool disabled) { return DISABLED || disabled ? "DISABLED_" : ""; }
 
-  void MakeAndRegisterTestInfo(bool disabled, const std::string& type, const std::string& name, const std::string& /*file*/,
-                               int /*line*/,
-                               detail::type<TestInfo*(const char*, const char*, const char*, const char*, const void*,
-                                                      void (*)(), void (*)(), internal::TestFactoryBase*)>) {
+  static void MakeAndRegisterTestInfo(internal::TestFactoryBase* factory, bool disabled, const std::string& type,
+                                      const std::string& name, const std::string& /*file*/, int /*line*/,
+                                      detail::type<TestInfo*(const char*, const char*, const char*, const char*, const void*,
+                                                             void (*)(), void (*)(), internal::TestFactoryBase*)>) {
     internal::MakeAndRegisterTestInfo((IsDisabled(disabled) + type).c_str(), name.c_str(), nullptr, nullptr,
-                                      internal::GetTestTypeId(), Test::SetUpTestCase, Test::TearDownTestCase,
-                                      new internal::TestFactoryImpl<T>{});
+                                      internal::GetTestTypeId(), Test::SetUpTestCase, Test::TearDownTestCase, factory);
   }
 
   template <class... Ts>
-  void MakeAndRegisterTestInfo(bool disabled, const std::string& type, const std::string& name, const std::string& file,
-                               int line, detail::type<TestInfo*(Ts...)>) {
+  static void MakeAndRegisterTestInfo(internal::TestFactoryBase* factory, bool disabled, const std::string& type,
+                                      const std::string& name, const std::string& file, int line,
+                                      detail::type<TestInfo*(Ts...)>) {
     internal::MakeAndRegisterTestInfo((IsDisabled(disabled) + type).c_str(), name.c_str(), nullptr, nullptr,
                                       {file.c_str(), line}, internal::GetTestTypeId(), Test::SetUpTestCase,
-                                      Test::TearDownTestCase, new internal::TestFactoryImpl<T>{});
+                                      Test::TearDownTestCase, factory);
   }
 
   template <class TestType>
@@ -104,14 +244,49 @@ class GTestAutoRegister {
     return str;
   }
 
+  static void Register(const filter& f) {
+    const std::string type = GetTypeName(detail::type<typename T::TEST_TYPE>{});
+    const auto test = IsDisabled(DISABLED) + type + "." + T::TEST_NAME::c_str();
+    if (f.matches(test)) {
+      MakeAndRegisterTestInfo(make_test_factory<T>(test, union_cast<const void*>(&T::TestBodyImpl)), DISABLED, type,
+                              T::TEST_NAME::c_str(), T::TEST_FILE, T::TEST_LINE,
+                              detail::type<decltype(internal::MakeAndRegisterTestInfo)>{});
+    }
+  }
+
+  template <class TParam>
+  static lazy_generator<TParam> (*&LazyParams())() {
+    static lazy_generator<TParam> (*params)() = nullptr;
+    return params;
+  }
+
+  template <class TParam>
+  static void RegisterLazy(const filter& f) {
+    const std::string type = GetTypeName(detail::type<typename T::TEST_TYPE>{});
+    const auto test_case = std::string{T::TEST_NAME::c_str()} + "/" + type;
+    if (f.matches(IsDisabled(DISABLED) + test_case + "." + type)) {
+      MakeAndRegisterTestInfo(new lazy_param_test_factory<T, TParam>{LazyParams<TParam>()()}, DISABLED, test_case, type,
+                              T::TEST_FILE, T::TEST_LINE, detail::type<decltype(internal::MakeAndRegisterTestInfo)>{});
+    }
+  }
+
+  registration registration_{&GTestAutoRegister::Register, nullptr};
+
  public:
-  GTestAutoRegister() {
-    MakeAndRegisterTestInfo(DISABLED, GetTypeName(detail::type<typename T::TEST_TYPE>{}), T::TEST_NAME::c_str(), T::TEST_FILE,
-                            T::TEST_LINE, detail::type<decltype(internal::MakeAndRegisterTestInfo)>{});
+  GTestAutoRegister() { lazy_registry::add(registration_); }
+
+  /**
+   * Lazy generators are registered as a single test which generates parameters while running
+   */
+  template <class TEval, class TGenerateNames, class TParam>
+  GTestAutoRegister(const TEval&, const TGenerateNames&, lazy_generator<TParam> (*params)()) {
+    LazyParams<TParam>() = params;
+    registration_.make = &GTestAutoRegister::RegisterLazy<TParam>;
+    lazy_registry::add(registration_);
   }
 
-  template <class TEval, class TGenerateNames>
-  GTestAutoRegister(const TEval& eval, const TGenerateNames& genNames) {
+  template <class TEval, class TGenerateNames, class TParams>
+  GTestAutoRegister(const TEval& eval, const TGenerateNames& genNames, TParams (*)()) {
     UnitTest::GetInstance()
         ->parameterized_test_registry()
         .GetTestCasePatternHolder<T>(GetTypeName(detail::type<typename T::TEST_TYPE>{}), {T::TEST_FILE, T::TEST_LINE})
@@ -164,6 +339,35 @@ class GTest<T, TParamType, std::true_type, std::true_type> : public T {};
 template <class T = detail::none_t, class TParamType = void>
 class GTest : public detail::GTest<T, TParamType> {};
 
+/**
+ * Lazy counterparts of gtest generators, parameters are generated while the test is running
+ */
+template <class T, class TStep = T>
+inline auto LazyRange(T begin, T end, TStep step = 1) {
+  using value_t = std::common_type_t<T, TStep>;
+  return detail::lazy_generator<T>{
+      detail::range_size<value_t>(begin, end, step, std::is_floating_point<value_t>{}),
+      [=](std::size_t index) { return static_cast<T>(begin + index * step); }};
+}
+
+template <class TContainer>
+inline auto LazyValuesIn(const TContainer& container) {
+  const auto values = std::make_shared<const std::vector<typename TContainer::value_type>>(std::begin(container),
+                                                                                           std::end(container));
+  return detail::lazy_generator<typename TContainer::value_type>{values->size(),
+                                                                 [=](std::size_t index) { return (*values)[index]; }};
+}
+
+template <class T, class... Ts>
+inline auto LazyValues(const T& value, const Ts&... values) {
+  return LazyValuesIn(std::vector<std::common_type_t<T, Ts...>>{value, values...});
+}
+
+template <class... Ts>
+inline auto LazyCombine(const detail::lazy_generator<Ts>&... generators) {
+  return detail::combine(generators...);
+}
+
 }  // v1
 }  // testing
 
@@ -194,6 +398,7 @@ class GTest : public detail::GTest<T, TParamType> {};
         test.SetUp();                                                                                                     \
         test.TestBodyImpl(tr);                                                                                            \
         test.TearDown();                                                                                                  \
+        tr.should_deadline = {};                                                                                          \
       };                                                                                                                  \
     }                                                                                                                     \
   };                                                                                                                      \
@@ -210,16 +415,17 @@ class GTest : public detail::GTest<T, TParamType> {};
 
 #define __GTEST_IMPL_3(DISABLED, TYPE, NAME, PARAMS)                                                                        \
   using __GUNIT_CAT(GTEST_TEST_NAME, __LINE__) = decltype(__GUNIT_CAT(NAME, _gtest_string));                                \
+  static auto __GUNIT_CAT(GTEST_PARAMS, __LINE__)() { return PARAMS; }                                                      \
   static ::testing::internal::ParamGenerator<::testing::detail::apply_t<std::common_type_t, decltype(PARAMS)>> __GUNIT_CAT( \
       GTEST_EVAL, __LINE__)() {                                                                                             \
-    return PARAMS;                                                                                                          \
+    return __GUNIT_CAT(GTEST_PARAMS, __LINE__)();                                                                           \
   }                                                                                                                         \
   static std::string __GUNIT_CAT(GTEST_GENERATE_NAMES, __LINE__)(                                                           \
       const ::testing::TestParamInfo<::testing::detail::apply_t<std::common_type_t, decltype(PARAMS)>>& info) {             \
     return ::testing::internal::GetParamNameGen<::testing::detail::apply_t<std::common_type_t, decltype(PARAMS)>>()(info);  \
   }                                                                                                                         \
   __GTEST_IMPL(DISABLED, TYPE, __GUNIT_CAT(GTEST_TEST_NAME, __LINE__), PARAMS, &__GUNIT_CAT(GTEST_EVAL, __LINE__),          \
-               &__GUNIT_CAT(GTEST_GENERATE_NAMES, __LINE__))
+               &__GUNIT_CAT(GTEST_GENERATE_NAMES, __LINE__), &__GUNIT_CAT(GTEST_PARAMS, __LINE__))
 
 #define GTEST(...) __GUNIT_CAT(__GTEST_IMPL_, __GUNIT_SIZE(__VA_ARGS__))(false, __VA_ARGS__)
 #define DISABLED_GTEST(...) __GUNIT_CAT(__GTEST_IMPL_, __GUNIT_SIZE(__VA_ARGS__))(true, __VA_ARGS__)
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "GUnit/Detail/CacheUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+int cached_function(int i) { return i * 2; }
+
+TEST(CacheUtils, ShouldStorePassedTests) {
+  const std::string path = ".gunit-cache/CacheUtils.ShouldStorePassedTests";
+  std::remove(path.c_str());
+
+  {
+    test_cache cache{path};
+    EXPECT_FALSE(cache.passed("a", 1));
+    cache.update("a", 1, true);
+    cache.update("b", 2, true);
+    cache.update("c", 3, false);
+    cache.save();
+  }
+
+  {
+    test_cache cache{path};
+    EXPECT_TRUE(cache.passed("a", 1));
+    EXPECT_FALSE(cache.passed("a", 2));
+    EXPECT_TRUE(cache.passed("b", 2));
+    EXPECT_FALSE(cache.passed("c", 3));
+    cache.update("b", 2, false);
+    cache.save();
+  }
+
+  {
+    test_cache cache{path};
+    EXPECT_TRUE(cache.passed("a", 1));
+    EXPECT_FALSE(cache.passed("b", 2));
+  }
+
+  std::remove(path.c_str());
+}
+
+TEST(CacheUtils, ShouldCacheValuesOfFiles) {
+  const std::string path = ".gunit-cache/CacheUtils.ShouldCacheValuesOfFiles";
+  const std::string file = "CacheUtils.ShouldCacheValuesOfFiles.txt";
+  std::remove(path.c_str());
+  const auto write = [&](const std::string& content) {
+    std::unique_ptr<FILE, decltype(&std::fclose)> f{std::fopen(file.c_str(), "wb"), &std::fclose};
+    std::fwrite(content.data(), 1, content.size(), f.get());
+  };
+  write("content");
+
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(nullptr, cache.get(file).data());
+    cache.put(file, "value");
+    EXPECT_EQ(std::string{"value"}, cache.get(file).str());
+    cache.save();
+  }
+
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(std::string{"value"}, cache.get(file).str());
+  }
+
+  {
+    file_cache cache{path, 2};
+    EXPECT_EQ(nullptr, cache.get(file).data());
+  }
+
+  write("changed!");
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(nullptr, cache.get(file).data());
+    cache.put(file, "new value");
+    cache.save();
+  }
+
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(std::string{"new value"}, cache.get(file).str());
+  }
+
+  const auto cache_size = [&] {
+    struct stat st {};
+    ::stat(path.c_str(), &st);
+    return st.st_size;
+  };
+  const timespec touched[2] = {{1000000000, 0}, {1000000000, 0}};
+  ::utimensat(AT_FDCWD, file.c_str(), touched, 0);
+  const auto size = cache_size();
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(std::string{"new value"}, cache.get(file).str());
+    cache.save();
+  }
+  EXPECT_GT(cache_size(), size);
+
+  const auto refreshed = cache_size();
+  {
+    file_cache cache{path, 1};
+    EXPECT_EQ(std::string{"new value"}, cache.get(file).str());
+    cache.save();
+  }
+  EXPECT_EQ(refreshed, cache_size());
+
+  std::remove(file.c_str());
+  std::remove(path.c_str());
+}
+
+TEST(CacheUtils, ShouldFingerprintFunction) {
+  const auto code = reinterpret_cast<const void*>(&cached_function);
+  EXPECT_NE(0u, fingerprint(code));
+  EXPECT_EQ(fingerprint(code), fingerprint(code));
+  EXPECT_EQ(0u, fingerprint(static_cast<const char*>(code) + 1));
+}
+
+}  // detail
+}  // v1
+}  // testing
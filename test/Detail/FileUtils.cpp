@@ -6,6 +6,11 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 //
 #include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "GUnit/Detail/FileUtils.h"
 
@@ -19,6 +24,43 @@ TEST(FileUtils, ShouldReturnBaseName) {
   EXPECT_EQ(std::string{"file.hpp"}, basename("/b/file.hpp"));
 }
 
+TEST(FileUtils, ShouldReadUtf8File) {
+  EXPECT_THROW(read_file("FileUtils.ShouldReadUtf8File.not_found"), std::runtime_error);
+
+  const std::string path = "FileUtils.ShouldReadUtf8File.feature";
+  {
+    std::unique_ptr<FILE, decltype(&std::fclose)> file{std::fopen(path.c_str(), "wb"), &std::fclose};
+    std::fputs("Feature: \xC3\xA7\n", file.get());
+  }
+  EXPECT_EQ(std::wstring{L"Feature: \u00E7\n"}, read_file(path));
+  std::remove(path.c_str());
+}
+
+TEST(FileUtils, ShouldReadDirectory) {
+  const std::string root = "FileUtils.ShouldReadDirectory";
+  ::mkdir(root.c_str(), 0755);
+  ::mkdir((root + "/b").c_str(), 0755);
+  ::mkdir((root + "/a").c_str(), 0755);
+  std::fclose(std::fopen((root + "/z.feature").c_str(), "wb"));
+  std::fclose(std::fopen((root + "/c.feature").c_str(), "wb"));
+  std::fclose(std::fopen((root + "/.hidden").c_str(), "wb"));
+
+  EXPECT_TRUE(is_directory(root));
+  EXPECT_FALSE(is_directory(root + "/c.feature"));
+  EXPECT_FALSE(is_directory(root + "/not_found"));
+  EXPECT_NE(0u, modification_time(root + "/c.feature"));
+  EXPECT_EQ(0u, modification_time(root + "/not_found"));
+
+  const auto entries = read_directory(root);
+  EXPECT_EQ((std::vector<std::string>{"c.feature", "z.feature"}), entries.files);
+  EXPECT_EQ((std::vector<std::string>{"a", "b"}), entries.directories);
+  EXPECT_TRUE(read_directory(root + "/not_found").files.empty());
+
+  for (const auto& path : {"/z.feature", "/c.feature", "/.hidden", "/a", "/b", ""}) {
+    std::remove((root + path).c_str());
+  }
+}
+
 } // detail
 } // v1
 } // testing
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GUnit/Detail/ProfileUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+TEST(ProfileUtils, ShouldCalculatePercentiles) {
+  duration_histogram histogram{};
+  for (auto i = 1u; i <= 1000; ++i) {
+    histogram.add(i * 1000);
+  }
+  EXPECT_EQ(1000u * 1000, histogram.percentile(100));
+  EXPECT_GE(histogram.percentile(99), 990u * 1000);
+  EXPECT_LE(histogram.percentile(99), 990u * 1000 * 9 / 8);
+  EXPECT_GE(histogram.percentile(50), 500u * 1000);
+  EXPECT_LE(histogram.percentile(50), 500u * 1000 * 9 / 8);
+
+  duration_histogram small{};
+  small.add(3);
+  small.add(7);
+  EXPECT_EQ(3u, small.percentile(50));
+  EXPECT_EQ(7u, small.percentile(99));
+
+  histogram.merge(small);
+  EXPECT_EQ(3u, histogram.percentile(0.1));
+}
+
+TEST(ProfileUtils, ShouldAggregateStepsOfAllThreads) {
+  step_profiler profiler{};
+  std::vector<std::thread> threads{};
+  for (auto i = 0; i < 4; ++i) {
+    threads.emplace_back([&profiler] {
+      for (auto j = 0; j < 100; ++j) {
+        profiler.record("Given", "I have {n}", "steps.cpp", 1, 10, 1);
+        profiler.record("When", "I press add", "", 0, 20, 0);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  profiler.record("Then", "the result is {n}", "steps.cpp", 3, 100000, 0);
+
+  const auto profiles = profiler.profiles();
+  ASSERT_EQ(3u, profiles.size());
+  EXPECT_EQ("Then", profiles[0].keyword);
+  EXPECT_EQ(1u, profiles[0].calls);
+  EXPECT_EQ("When", profiles[1].keyword);
+  EXPECT_EQ(400u, profiles[1].calls);
+  EXPECT_EQ(8000u, profiles[1].total);
+  EXPECT_EQ("Given", profiles[2].keyword);
+  EXPECT_EQ("steps.cpp", profiles[2].file);
+  EXPECT_EQ(400u, profiles[2].hooks);
+  EXPECT_EQ(10u, profiles[2].durations.percentile(99));
+}
+
+TEST(ProfileUtils, ShouldFormatProfiles) {
+  EXPECT_EQ("999 ns", format_duration(999));
+  EXPECT_EQ("1.500 us", format_duration(1500));
+  EXPECT_EQ("12.345 ms", format_duration(12345000));
+  EXPECT_EQ("3000.000 s", format_duration(3000000000000));
+
+  step_profiler profiler{};
+  profiler.record("Given", "I have \"{n}\"", "steps.cpp", 12, 2000, 500);
+  profiler.record("When", "I press add", "", 0, 1000, 0);
+  const auto profiles = profiler.profiles();
+
+  EXPECT_EQ(std::string{"[ PROFILE  ]      calls         total          mean           p99         hooks  step\n"
+                        "[ PROFILE  ]          1      2.000 us      2.000 us      2.000 us        500 ns  "
+                        "Given I have \"{n}\" # steps.cpp:12\n"
+                        "[ PROFILE  ]          1      1.000 us      1.000 us      1.000 us          0 ns  When I press add\n"},
+            format_profiles(profiles));
+  EXPECT_EQ(std::string{"[\n"
+                        "  {\"keyword\":\"Given\",\"pattern\":\"I have \\\"{n}\\\"\",\"file\":\"steps.cpp\",\"line\":12,"
+                        "\"calls\":1,\"total\":2000,\"mean\":2000,\"p99\":2000,\"max\":2000,\"hooks\":500},\n"
+                        "  {\"keyword\":\"When\",\"pattern\":\"I press add\",\"file\":\"\",\"line\":0,"
+                        "\"calls\":1,\"total\":1000,\"mean\":1000,\"p99\":1000,\"max\":1000,\"hooks\":0}\n"
+                        "]\n"},
+            profiles_to_json(profiles));
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h> // MatchesRegex
 
+#include <cstdio>
+#include <memory>
 #include "GUnit/Detail/ProgUtils.h"
 
 namespace testing {
@@ -32,6 +34,68 @@ TEST(ProgUtils, ShouldReturnCallStack) {
   EXPECT_THAT(call_stack("\n", 1, 2), testing::MatchesRegex(".*ProgUtils_ShouldReturnCallStack_Test.*"));
 }
 
+void function_size_test() {}
+
+#if defined(__linux__)
+TEST(ProgUtils, ShouldReturnFunctionSize) {
+  EXPECT_LT(0u, function_size(reinterpret_cast<const void*>(&function_size_test)));
+  EXPECT_EQ(0u, function_size(nullptr));
+}
+#endif
+
+TEST(ProgUtils, ShouldReturnFlag) {
+  EXPECT_EQ(std::string{}, GetFlag("not_set"));
+  EXPECT_EQ(std::string{"default"}, GetFlag("not_set", "default"));
+  setenv("GUNIT_PROG_UTILS_FLAG", "42", 1);
+  EXPECT_EQ(std::string{"42"}, GetFlag("prog_utils_flag"));
+  setenv("GUNIT_PROG_UTILS_FLAG", "1", 1);
+  EXPECT_EQ(std::string{"1"}, GetFlag("prog_utils_flag", {}, "bare"));
+  unsetenv("GUNIT_PROG_UTILS_FLAG");
+}
+
+TEST(ProgUtils, ShouldReturnBoolFlag) {
+  EXPECT_FALSE(GetBoolFlag("not_set"));
+  for (const auto& off : {"0", "false", ""}) {
+    setenv("GUNIT_PROG_UTILS_FLAG", off, 1);
+    EXPECT_FALSE(GetBoolFlag("prog_utils_flag"));
+  }
+  for (const auto& on : {"1", "true", "yes"}) {
+    setenv("GUNIT_PROG_UTILS_FLAG", on, 1);
+    EXPECT_TRUE(GetBoolFlag("prog_utils_flag"));
+  }
+  unsetenv("GUNIT_PROG_UTILS_FLAG");
+}
+
+TEST(ProgUtils, ShouldRunForked) {
+  auto called = false;
+  const auto forked = run_forked([&](const auto& write) {
+    called = true;
+    write("a");
+    write("b");
+  });
+  EXPECT_FALSE(called);
+  EXPECT_TRUE(forked.exited);
+  EXPECT_EQ(std::string{"ab"}, forked.out);
+
+  const auto crashed = run_forked([](const auto& write) {
+    write("a");
+    _exit(3);
+  });
+  EXPECT_FALSE(crashed.exited);
+  EXPECT_EQ(std::string{"a"}, crashed.out);
+  EXPECT_EQ(std::string{"exited with 3"}, crashed.status);
+}
+
+TEST(ProgUtils, ShouldFlushStdioOfForkedChild) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  const auto forked = run_forked([&](const auto&) { std::fputs("buffered", file.get()); });
+  EXPECT_TRUE(forked.exited);
+  std::rewind(file.get());
+  char buffer[16] = {};
+  EXPECT_EQ(8u, std::fread(buffer, 1, sizeof(buffer), file.get()));
+  EXPECT_EQ(std::string{"buffered"}, buffer);
+}
+
 } // detail
 } // v1
 } // testing
@@ -87,6 +87,202 @@ TEST(RegexUtils, ShouldReturnMatches) {
   EXPECT_EQ("table", matches(n7, t5)[0]);
 }
 
+TEST(RegexUtils, ShouldMatchSteps) {
+  step_matcher matcher{};
+  matcher.add("I press add", 0);
+  matcher.add("I have a {number} to read", 1);
+  matcher.add("I have a {number} and a {second number} to read", 2);
+  matcher.add(R"(I have a '{text}' and a {second number} to read)", 3);
+  matcher.add("I have a {} blah", 4);
+  matcher.add("I have the following {table}", 5);
+  matcher.add("I press {button}", 6);
+
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find(""));
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find("I press"));
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find("I have a 42 to read now"));
+  EXPECT_EQ((std::vector<std::size_t>{1}), matcher.find("I have a 42 to read"));
+  EXPECT_EQ((std::vector<std::size_t>{2}), matcher.find("I have a 1234 and a fifty to read"));
+  EXPECT_EQ((std::vector<std::size_t>{3}), matcher.find(R"(I have a 'text with spaces' and a fifty to read)"));
+  EXPECT_EQ((std::vector<std::size_t>{4}), matcher.find("I have a 42 blah"));
+  EXPECT_EQ((std::vector<std::size_t>{5}), matcher.find("I have the following table"));
+  EXPECT_EQ((std::vector<std::size_t>{6}), matcher.find("I press sub"));
+  EXPECT_EQ(2u, matcher.find("I press add").size());
+  EXPECT_EQ(1u, matcher.find("I press add", 1).size());
+}
+
+TEST(RegexUtils, ShouldMatchCompiledPatterns) {
+  {
+    using pattern = compiled_pattern<decltype("I press add"_gtest_string)>;
+    pattern::captures_t captures{};
+    EXPECT_TRUE(pattern::match("I press add", captures));
+    EXPECT_FALSE(pattern::match("I press", captures));
+    EXPECT_FALSE(pattern::match("I press add now", captures));
+  }
+
+  {
+    using pattern = compiled_pattern<decltype("I have a {number} and a {second number} to read"_gtest_string)>;
+    pattern::captures_t captures{};
+    static_assert(2 == std::tuple_size<pattern::captures_t>::value, "");
+    const std::string step = "I have a 1234 and a fifty to read";
+    EXPECT_TRUE(pattern::match(step, captures));
+    EXPECT_EQ("1234", captures[0]);
+    EXPECT_EQ("fifty", captures[1]);
+    EXPECT_EQ(step.data() + 9, captures[0].data());
+    EXPECT_FALSE(pattern::match("I have a 42 to read", captures));
+  }
+
+  {
+    using pattern = compiled_pattern<decltype("I have a '{text}' and {n}"_gtest_string)>;
+    pattern::captures_t captures{};
+    EXPECT_TRUE(pattern::match("I have a 'text with spaces' and 42", captures));
+    EXPECT_EQ("text with spaces", captures[0]);
+    EXPECT_EQ("42", captures[1]);
+    EXPECT_TRUE(pattern::match("I have a '' and 42", captures));
+    EXPECT_EQ("", captures[0]);
+    EXPECT_FALSE(pattern::match("I have a text and 42", captures));
+  }
+}
+
+TEST(RegexUtils, ShouldMatchCucumberExpressions) {
+  {
+    const cucumber_expression expression{"I have {int} cucumber(s) in my belly/stomach"};
+    string_view captures[1]{};
+    EXPECT_EQ(1u, expression.parameters());
+    EXPECT_TRUE(expression.match("I have 42 cucumbers in my belly", captures));
+    EXPECT_EQ("42", captures[0]);
+    EXPECT_TRUE(expression.match("I have -1 cucumber in my stomach", captures));
+    EXPECT_EQ("-1", captures[0]);
+    EXPECT_FALSE(expression.match("I have many cucumbers in my belly", captures));
+    EXPECT_FALSE(expression.match("I have 42 cucumbers in my", captures));
+  }
+
+  {
+    const cucumber_expression expression{"{float} and {word} with {string} then {}"};
+    string_view captures[4]{};
+    EXPECT_TRUE(expression.match("1.5e3 and blue with \"a 'b'\" then the rest", captures));
+    EXPECT_EQ("1.5e3", captures[0]);
+    EXPECT_EQ("blue", captures[1]);
+    EXPECT_EQ("a 'b'", captures[2]);
+    EXPECT_EQ("the rest", captures[3]);
+    EXPECT_TRUE(expression.match(".5 and x with '' then ", captures));
+    EXPECT_EQ(".5", captures[0]);
+    EXPECT_EQ("", captures[2]);
+    EXPECT_FALSE(expression.match("1.5 and blue with text then x", captures));
+  }
+
+  {
+    const cucumber_expression expression{R"(a \(b\) \{c\} d\/e)"};
+    EXPECT_EQ(0u, expression.parameters());
+    EXPECT_TRUE(expression.match("a (b) {c} d/e", nullptr));
+  }
+
+  {
+    const cucumber_expression expression{"{int} (big )cat/dog"};
+    string_view captures[1]{};
+    EXPECT_TRUE(expression.match("1 big cat", captures));
+    EXPECT_EQ("1", captures[0]);
+    EXPECT_TRUE(expression.match("2 dog", captures));
+    EXPECT_TRUE(expression.match("3 big dog", captures));
+    EXPECT_FALSE(expression.match("4 bigcat", captures));
+  }
+
+  EXPECT_THROW(cucumber_expression{"{unknown}"}, std::invalid_argument);
+  EXPECT_THROW(cucumber_expression{"{int"}, std::invalid_argument);
+  EXPECT_THROW(cucumber_expression{"cucumber(s"}, std::invalid_argument);
+}
+
+TEST(RegexUtils, ShouldMatchCucumberExpressionSteps) {
+  step_matcher matcher{};
+  matcher.add("I press add", 0);
+  matcher.add(cucumber_expression{"I have {int} cucumber(s) in my belly/stomach"}, 1);
+  matcher.add(cucumber_expression{"I have {float} litre(s)"}, 2);
+  matcher.add(cucumber_expression{"I say {string}"}, 3);
+  matcher.add(cucumber_expression{"I see {}"}, 4);
+  matcher.add(cucumber_expression{"I press/push add"}, 5);
+
+  EXPECT_EQ((std::vector<std::size_t>{1}), matcher.find("I have 42 cucumbers in my belly"));
+  EXPECT_EQ((std::vector<std::size_t>{1}), matcher.find("I have 1 cucumber in my stomach"));
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find("I have one cucumber in my stomach"));
+  EXPECT_EQ((std::vector<std::size_t>{2}), matcher.find("I have 0.5 litres"));
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find("I have 0.5 cucumbers in my belly"));
+  EXPECT_EQ((std::vector<std::size_t>{3}), matcher.find("I say \"hello world\""));
+  EXPECT_EQ((std::vector<std::size_t>{}), matcher.find("I say hello"));
+  EXPECT_EQ((std::vector<std::size_t>{4}), matcher.find("I see anything at all"));
+  EXPECT_EQ((std::vector<std::size_t>{5}), matcher.find("I push add"));
+  EXPECT_EQ(2u, matcher.find("I press add").size());
+}
+
+TEST(RegexUtils, ShouldFindEachCucumberExpressionStepOnce) {
+  step_matcher matcher{};
+  matcher.add(cucumber_expression{"I have {} and {}"}, 0);
+
+  EXPECT_EQ((std::vector<std::size_t>{0}), matcher.find("I have a and b and c"));
+  EXPECT_EQ((std::vector<std::size_t>{0}), matcher.find("I have " + std::string(10000, 'a') + " and b"));
+}
+
+TEST(RegexUtils, ShouldMatchPatternWithWildcards) {
+  EXPECT_TRUE(PatternMatchesString("", ""));
+  EXPECT_TRUE(PatternMatchesString("*", ""));
+  EXPECT_TRUE(PatternMatchesString("*", "abc"));
+  EXPECT_TRUE(PatternMatchesString("a?c", "abc"));
+  EXPECT_TRUE(PatternMatchesString("a*c", "abbbc"));
+  EXPECT_TRUE(PatternMatchesString("*b*", "abc"));
+  EXPECT_TRUE(PatternMatchesString("a*b*c*d", "aXbYcZd"));
+  EXPECT_TRUE(PatternMatchesString("abc:def", "abc"));
+  EXPECT_FALSE(PatternMatchesString("", "a"));
+  EXPECT_FALSE(PatternMatchesString("a?c", "ac"));
+  EXPECT_FALSE(PatternMatchesString("a*c", "abcd"));
+  EXPECT_FALSE(PatternMatchesString("abc:def", "def"));
+
+  const std::string str(4096, 'a');
+  EXPECT_FALSE(PatternMatchesString("*a*a*a*a*a*a*a*a*a*a*a*a*b", str.c_str()));
+  EXPECT_TRUE(PatternMatchesString("*a*a*a*a*a*a*a*a*a*a*a*a*", str.c_str()));
+}
+
+TEST(RegexUtils, ShouldMatchGlobAgainstPath) {
+  EXPECT_TRUE(GlobMatchesPath("a.feature", "a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("*.feature", "a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("?.feature", "a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("features/*/*.feature", "features/calc/a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("features/**/*.feature", "features/a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("features/**/*.feature", "features/calc/add/a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("**/*.feature", "a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("features/**", "features/calc/a.feature"));
+  EXPECT_TRUE(GlobMatchesPath("./**/c*/*.feature", "./features/calc/a.feature"));
+  EXPECT_FALSE(GlobMatchesPath("*.feature", "features/a.feature"));
+  EXPECT_FALSE(GlobMatchesPath("features/*.feature", "features/calc/a.feature"));
+  EXPECT_FALSE(GlobMatchesPath("features/**/*.feature", "features/a.txt"));
+  EXPECT_FALSE(GlobMatchesPath("features/**/*.feature", "other/a.feature"));
+  EXPECT_FALSE(GlobMatchesPath("features/*", "features"));
+  EXPECT_FALSE(GlobMatchesPath("a", "a/b"));
+}
+
+TEST(RegexUtils, ShouldMatchFilter) {
+  EXPECT_TRUE(filter{}.matches("any"));
+  EXPECT_TRUE(filter{"*"}.matches(""));
+  EXPECT_TRUE(filter{"a*"}.matches("abc"));
+  EXPECT_TRUE(filter{"b:a*"}.matches("abc"));
+  EXPECT_TRUE(filter{"abc"}.matches("abc"));
+  EXPECT_TRUE(filter{"-b*"}.matches("abc"));
+  EXPECT_TRUE(filter{"a*-*d"}.matches("abc"));
+  EXPECT_FALSE(filter{"abc"}.matches("abcd"));
+  EXPECT_FALSE(filter{"b*"}.matches("abc"));
+  EXPECT_FALSE(filter{"-a*"}.matches("abc"));
+  EXPECT_FALSE(filter{"*-x:a*"}.matches("abc"));
+
+  EXPECT_TRUE(filter{}.matches_prefix("any"));
+  EXPECT_TRUE(filter{"Calc*.*"}.matches_prefix("Calc Addition"));
+  EXPECT_TRUE(filter{"Calc Addition.Add"}.matches_prefix("Calc"));
+  EXPECT_TRUE(filter{"*Addition[@*].*"}.matches_prefix("Calc Addition"));
+  EXPECT_TRUE(filter{"Table.*:Calc?Add*"}.matches_prefix("Calc Addition"));
+  EXPECT_FALSE(filter{"Table.*"}.matches_prefix("Calc Addition"));
+  EXPECT_FALSE(filter{"Calc Addition"}.matches_prefix("Calc Addition2"));
+  EXPECT_TRUE(filter{"*Division*"}.matches_prefix("Calc Addition"));
+
+  EXPECT_TRUE(FilterMatchesShould("call this one", "call*-*not*"));
+  EXPECT_FALSE(FilterMatchesShould("call this one but not this one", "call*-*not*"));
+}
+
 }  // detail
 }  // v1
 }  // testing
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "GUnit/Detail/RegistryUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+std::vector<std::string> made{};
+
+TEST(RegistryUtils, ShouldMaterializeRegistrationsInOrder) {
+  made.clear();
+  registration r1{[](const filter& f) { made.push_back(f.matches("r1") ? "r1" : "!r1"); }, nullptr};
+  registration r2{[](const filter& f) { made.push_back(f.matches("r2") ? "r2" : "!r2"); }, nullptr};
+
+  lazy_registry::add(r1);
+  lazy_registry::add(r2);
+  EXPECT_TRUE(made.empty());
+
+  lazy_registry::materialize();
+  EXPECT_EQ((std::vector<std::string>{"r1", "r2"}), made);
+
+  lazy_registry::materialize();
+  EXPECT_EQ(2u, made.size());
+}
+
+TEST(RegistryUtils, ShouldMaterializeWithGTestFilter) {
+  made.clear();
+  registration r1{[](const filter& f) { made.push_back(f.matches("r1") ? "r1" : "!r1"); }, nullptr};
+  registration r2{[](const filter& f) { made.push_back(f.matches("r2") ? "r2" : "!r2"); }, nullptr};
+
+  const auto flag = GTEST_FLAG(filter);
+  GTEST_FLAG(filter) = "r2";
+  lazy_registry::add(r1);
+  lazy_registry::add(r2);
+  lazy_registry::materialize();
+  GTEST_FLAG(filter) = flag;
+
+  EXPECT_EQ((std::vector<std::string>{"!r1", "r2"}), made);
+}
+
+}  // detail
+}  // v1
+}  // testing
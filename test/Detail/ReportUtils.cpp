@@ -0,0 +1,251 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GUnit/Detail/ReportUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+auto read(FILE* file) {
+  std::string result{};
+  std::rewind(file);
+  char buffer[256] = {};
+  while (const auto size = std::fread(buffer, 1, sizeof(buffer), file)) {
+    result.append(buffer, size);
+  }
+  return result;
+}
+
+TEST(ReportUtils, ShouldFormatShouldAndSteps) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  async_reporter reporter{file.get()};
+
+  reporter.OnShould("SHOULD", "do something", false);
+  reporter.OnShould("SHOULD", "do nothing", true);
+  reporter.OnStep("Given", "I have a step", "steps.cpp", 42);
+  reporter.OnScenarioEnd();
+  EXPECT_EQ(std::string{}, read(file.get()));
+
+  reporter.Flush();
+  EXPECT_EQ(std::string{"[ SHOULD   ] do something\n"
+                        "[ DISABLED ] do nothing\n"
+                        "\033[0;96m[    Given ] I have a step" +
+                        std::string(47, ' ') + "# steps.cpp:42\033[m\n\n"},
+            read(file.get()));
+}
+
+TEST(ReportUtils, ShouldWriteInBatches) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  async_reporter reporter{file.get()};
+  const auto name = std::string(1024, 'x');
+
+  for (auto i = 0; i < 1024; ++i) {
+    reporter.OnShould("SHOULD", name, false);
+  }
+  reporter.Flush();
+
+  EXPECT_EQ(1024u * (name.size() + sizeof("[ SHOULD   ] ")), read(file.get()).size());
+}
+
+TEST(ReportUtils, ShouldKeepOrderWithSharedOutput) {
+  internal::CaptureStdout();
+  {
+    async_reporter reporter{stdout};
+    reporter.OnShould("SHOULD", "first", false);
+    std::printf("output of first\n");
+    reporter.OnShould("SHOULD", "second", false);
+  }
+  EXPECT_EQ(std::string{"[ SHOULD   ] first\noutput of first\n[ SHOULD   ] second\n"},
+            internal::GetCapturedStdout());
+}
+
+TEST(ReportUtils, ShouldKeepOutputPerReporter) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  async_reporter reporter{file.get()};
+  reporter.OnShould("SHOULD", "be written to the file", false);
+
+  internal::CaptureStdout();
+  {
+    async_reporter console{stdout};
+    console.OnShould("SHOULD", "be written to stdout", false);
+  }
+  EXPECT_EQ(std::string{"[ SHOULD   ] be written to stdout\n"}, internal::GetCapturedStdout());
+
+  std::thread{[&] { reporter.OnShould("SHOULD", "be written by another thread", false); }}.join();
+  reporter.Flush();
+  EXPECT_EQ(std::string{"[ SHOULD   ] be written to the file\n[ SHOULD   ] be written by another thread\n"},
+            read(file.get()));
+}
+
+TEST(ReportUtils, ShouldWriteOutputOnceWhenForkedAfterFlush) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  async_reporter reporter{file.get()};
+  const auto name = std::string(1024, 'x');
+  for (auto i = 0; i < 128; ++i) {  // written by the writer thread
+    reporter.OnShould("SHOULD", name, false);
+  }
+  reporter.Flush();
+
+  const auto result = run_forked([&](const auto& write) {
+    for (auto i = 0; i < 128; ++i) {
+      reporter.OnShould("SHOULD", "child", false);
+    }
+    reporter.Flush();
+    write("done");
+  });
+
+  EXPECT_TRUE(result.exited);
+  EXPECT_EQ(std::string{"done"}, result.out);
+  EXPECT_EQ(128u * (name.size() + sizeof("[ SHOULD   ] ") + sizeof("[ SHOULD   ] child")), read(file.get()).size());
+}
+
+TEST(ReportUtils, ShouldReplaceReporter) {
+  struct counting_reporter : Reporter {
+    explicit counting_reporter(int& calls) : calls(calls) {}
+    void OnShould(const std::string&, const std::string&, bool) override { ++calls; }
+    void OnStep(const std::string&, const std::string&, const std::string&, int) override { ++calls; }
+    void OnScenarioEnd() override {}
+    void Flush() override {}
+    int& calls;
+  };
+
+  auto calls = 0;
+  SetReporter(std::make_unique<counting_reporter>(calls));
+  GetReporter().OnShould("SHOULD", "be counted", false);
+  GetReporter().OnStep("When", "counted", "", 0);
+  SetReporter(std::make_unique<quiet_reporter>());
+  GetReporter().OnShould("SHOULD", "not be counted", false);
+  EXPECT_EQ(2, calls);
+}
+
+TEST(ReportUtils, ShouldRecordAndReplayOutputOfThread) {
+  std::shared_ptr<FILE> file{std::tmpfile(), std::fclose};
+  async_reporter reporter{file.get()};
+  recording_reporter recorded{};
+
+  {
+    const scoped_reporter scoped{recorded};
+    EXPECT_EQ(&recorded, &GetReporter());
+    GetReporter().OnShould("SHOULD", "be recorded", false);
+    GetReporter().OnScenarioEnd();
+  }
+  EXPECT_NE(&recorded, &GetReporter());
+
+  recorded.replay(reporter);
+  reporter.Flush();
+  EXPECT_EQ(std::string{"[ SHOULD   ] be recorded\n\n"}, read(file.get()));
+}
+
+TEST(ReportUtils, ShouldRecordAndReplayStepResults) {
+  recording_reporter recorded{};
+  recorded.OnScenario("Calc", "calc.feature", "Add", 3, {"@smoke"});
+  recorded.OnStepEnd("failed", 42, "message");
+
+  std::string out{};
+  recorded.save(out);
+  recording_reporter loaded{};
+  string_view in{out};
+  ASSERT_TRUE(loaded.load(in));
+
+  struct results_reporter : quiet_reporter {
+    void OnScenario(const std::string& feature, const std::string& file, const std::string& name, int line,
+                    const std::vector<std::string>& tags) override {
+      events += feature + ' ' + file + ' ' + name + ' ' + std::to_string(line) + ' ' + tags.front() + '\n';
+    }
+    void OnStepEnd(const std::string& status, std::uint64_t duration, const std::string& message) override {
+      events += status + ' ' + std::to_string(duration) + ' ' + message + '\n';
+    }
+    std::string events{};
+  } reporter{};
+  loaded.replay(reporter);
+  EXPECT_EQ(std::string{"Calc calc.feature Add 3 @smoke\nfailed 42 message\n"}, reporter.events);
+}
+
+TEST(ReportUtils, ShouldWriteCucumberJson) {
+  const std::string path = "ReportUtils.ShouldWriteCucumberJson.json";
+  cucumber_writer writer{path};
+  writer.begin_test("Calc", "Add");
+  writer.OnScenario("Calc", "calc.feature", "Add \"numbers\"", 3, {"@smoke"});
+  writer.OnStep("Given", "I have 1", "steps.cpp", 42);
+  writer.OnStepEnd("passed", 1000, {});
+  writer.OnStep("Then", "the result is 2", "calc.feature", 5);
+  writer.OnStepEnd("failed", 2000, "Expected\n2");
+  writer.end_test(true, 1);
+  writer.begin_test("Calc", "Undefined");
+  writer.OnScenario("Calc", "calc.feature", "Undefined", 7, {});
+  writer.add_failure("not implemented");
+  writer.end_test(true, 0);
+  writer.begin_test("Should", "not be reported");
+  writer.end_test(false, 0);
+  writer.close();
+
+  std::shared_ptr<FILE> file{std::fopen(path.c_str(), "rb"), std::fclose};
+  EXPECT_EQ(std::string{
+                R"([{"uri":"calc.feature","id":"calc","keyword":"Feature","name":"Calc","elements":[)"
+                R"({"id":"calc;add-\"numbers\"","keyword":"Scenario","type":"scenario","name":"Add \"numbers\"","line":3,)"
+                R"("tags":[{"name":"@smoke"}],"steps":[)"
+                R"({"keyword":"Given ","name":"I have 1","match":{"location":"steps.cpp:42"},)"
+                R"("result":{"status":"passed","duration":1000}},)"
+                R"({"keyword":"Then ","name":"the result is 2","match":{"location":"calc.feature:5"},)"
+                R"("result":{"status":"failed","duration":2000,"error_message":"Expected\n2"}}]},)"
+                R"({"id":"calc;undefined","keyword":"Scenario","type":"scenario","name":"Undefined","line":7,"tags":[],)"
+                R"("steps":[],"after":[{"match":{"location":"calc.feature"},)"
+                R"("result":{"status":"failed","duration":0,"error_message":"not implemented\n"}}]}]}])"
+                "\n"},
+            read(file.get()));
+  std::remove(path.c_str());
+}
+
+TEST(ReportUtils, ShouldWriteJUnitXml) {
+  const std::string path = "ReportUtils.ShouldWriteJUnitXml.xml";
+  junit_writer writer{path};
+  writer.begin_test("Calc", "Add");
+  writer.OnScenario("Calc", "calc.feature", "Add", 3, {});
+  writer.OnStep("Given", "I have <1>", "steps.cpp", 42);
+  writer.OnStepEnd("passed", 12000, {});
+  writer.add_failure("calc.cpp:1\nExpected\n2");
+  writer.end_test(true, 1234);
+  writer.begin_test("Should", "be reported");
+  writer.OnShould("SHOULD", "do something", false);
+  writer.end_test(false, 5);
+  writer.close();
+
+  std::shared_ptr<FILE> file{std::fopen(path.c_str(), "rb"), std::fclose};
+  EXPECT_EQ(std::string{"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<testsuites>\n"
+                        "  <testsuite name=\"Calc\">\n"
+                        "    <testcase classname=\"Calc\" name=\"Add\" time=\"1.234\" file=\"calc.feature\" line=\"3\">\n"
+                        "      <failure message=\"calc.cpp:1 Expected\">calc.cpp:1\nExpected\n2\n</failure>\n"
+                        "      <system-out>Given I have &lt;1&gt; (passed, 12 us)\n</system-out>\n"
+                        "    </testcase>\n"
+                        "  </testsuite>\n"
+                        "  <testsuite name=\"Should\">\n"
+                        "    <testcase classname=\"Should\" name=\"be reported\" time=\"0.005\">\n"
+                        "      <system-out>SHOULD do something\n</system-out>\n"
+                        "    </testcase>\n"
+                        "  </testsuite>\n"
+                        "</testsuites>\n"},
+            read(file.get()));
+  std::remove(path.c_str());
+}
+
+TEST(ReportUtils, ShouldRejectUnknownReports) {
+  EXPECT_THROW(make_report_writer("html:report.html"), std::runtime_error);
+  EXPECT_THROW(make_report_writer("junit"), std::runtime_error);
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -6,6 +6,7 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 //
 #include <gtest/gtest.h>
+#include <algorithm>
 
 #include "GUnit/Detail/StringUtils.h"
 
@@ -65,6 +66,149 @@ TEST(StringUtils, ShouldReturnTrimmedString) {
   }
 }
 
+TEST(StringUtils, ShouldViewString) {
+  const std::string str = "abc def";
+  const string_view view{str};
+  EXPECT_EQ(7u, view.size());
+  EXPECT_FALSE(view.empty());
+  EXPECT_TRUE(string_view{}.empty());
+  EXPECT_EQ('d', view[4]);
+  EXPECT_EQ(std::string{"def"}, view.substr(4).str());
+  EXPECT_EQ(std::string{"abc"}, view.substr(0, 3).str());
+  EXPECT_TRUE(view.substr(4) == "def");
+  EXPECT_TRUE(view != "abc");
+}
+
+TEST(StringUtils, ShouldSerializeAndDeserialize) {
+  std::string out{};
+  serialize(out, 42);
+  serialize(out, std::string{"str"});
+  serialize(out, std::vector<double>{1., 2.});
+
+  string_view in{out};
+  int i{};
+  std::string str{};
+  std::vector<double> values{};
+  EXPECT_TRUE(deserialize(in, i));
+  EXPECT_TRUE(deserialize(in, str));
+  EXPECT_TRUE(deserialize(in, values));
+  EXPECT_TRUE(in.empty());
+  EXPECT_EQ(42, i);
+  EXPECT_EQ(std::string{"str"}, str);
+  EXPECT_EQ((std::vector<double>{1., 2.}), values);
+  EXPECT_FALSE(deserialize(in, i));
+
+  string_view truncated{out.data(), out.size() - 1};
+  EXPECT_TRUE(deserialize(truncated, i));
+  EXPECT_TRUE(deserialize(truncated, str));
+  EXPECT_FALSE(deserialize(truncated, values));
+}
+
+TEST(StringUtils, ShouldDecodeUtf8) {
+  const auto decode = [](const std::string& str) { return utf8_decode(str.data(), str.size()); };
+  EXPECT_EQ(std::wstring{}, decode(""));
+  EXPECT_EQ(std::wstring{L"Feature: Calc\n"}, decode("Feature: Calc\n"));
+  EXPECT_EQ(std::wstring{L"abc"}, decode("\xEF\xBB\xBF" "abc"));
+  EXPECT_EQ(std::wstring{L"Funcionalidade: \u00E7\u00E3o"}, decode("Funcionalidade: \xC3\xA7\xC3\xA3o"));
+  EXPECT_EQ(std::wstring{L"\u20AC \U0001F600 a long ascii text"}, decode("\xE2\x82\xAC \xF0\x9F\x98\x80 a long ascii text"));
+  EXPECT_EQ(std::wstring{L"a\uFFFD\uFFFDb"}, decode("a\xC0\x80" "b"));
+  EXPECT_EQ(std::wstring{L"\uFFFD\uFFFD"}, decode("\xED\xA0"));
+  EXPECT_EQ(std::wstring{L"\uFFFD\uFFFD"}, decode("\xE2\x82"));
+}
+
+TEST(StringUtils, ShouldLexicalCast) {
+  EXPECT_EQ(42, lexical_cast<int>("42"));
+  EXPECT_EQ(-42, lexical_cast<const int&>(" -42"));
+  EXPECT_EQ(0, lexical_cast<int>(""));
+  EXPECT_EQ(18446744073709551615ull, lexical_cast<unsigned long long>("18446744073709551615"));
+  EXPECT_EQ(std::int16_t(-1), lexical_cast<std::int16_t>("-1"));
+  EXPECT_EQ(std::int16_t(-32768), lexical_cast<std::int16_t>("-32768"));
+  EXPECT_EQ(9223372036854775807ll, lexical_cast<long long>("9223372036854775807"));
+  EXPECT_EQ(0u, lexical_cast<unsigned>("-0"));
+  EXPECT_THROW(lexical_cast<std::uint16_t>("65536"), std::out_of_range);
+  EXPECT_THROW(lexical_cast<std::int16_t>("-32769"), std::out_of_range);
+  EXPECT_THROW(lexical_cast<unsigned>("-1"), std::out_of_range);
+  EXPECT_THROW(lexical_cast<unsigned long long>("18446744073709551616"), std::out_of_range);
+  EXPECT_DOUBLE_EQ(4.2, lexical_cast<double>("4.2"));
+  EXPECT_FLOAT_EQ(-1.5f, lexical_cast<float>("-1.5e0"));
+  EXPECT_DOUBLE_EQ(1.25, lexical_cast<double>(std::string(100, ' ') + "1.25"));
+  EXPECT_TRUE(lexical_cast<bool>("1"));
+  EXPECT_TRUE(lexical_cast<bool>("true"));
+  EXPECT_FALSE(lexical_cast<bool>("0"));
+  EXPECT_EQ('a', lexical_cast<char>(" a"));
+  EXPECT_EQ('4', lexical_cast<signed char>("42"));
+  EXPECT_EQ('4', lexical_cast<std::uint8_t>(" 42"));
+  EXPECT_EQ(0, lexical_cast<unsigned char>(""));
+  EXPECT_EQ(std::string{"two words"}, lexical_cast<std::string>("two words"));
+
+  const std::string str = "view";
+  const auto view = lexical_cast<string_view>(str);
+  EXPECT_EQ(str.data(), view.data());
+  EXPECT_EQ(4u, view.size());
+}
+
+} // detail
+
+namespace {
+struct point {
+  int x{};
+  int y{};
+};
+
+struct value {
+  int i{};
+  friend std::istream& operator>>(std::istream& is, value& v) { return is >> v.i; }
+};
+}  // namespace
+
+template <>
+struct LexicalCast<point> {
+  static point cast(detail::string_view str) {
+    const auto comma = std::find(str.begin(), str.end(), ',');
+    return {detail::lexical_cast<int>({str.begin(), std::size_t(comma - str.begin())}),
+            detail::lexical_cast<int>({comma + 1, std::size_t(str.end() - comma - 1)})};
+  }
+};
+
+namespace detail {
+
+TEST(StringUtils, ShouldLexicalCastUserTypes) {
+  EXPECT_EQ(42, lexical_cast<value>("42").i);
+  const auto p = lexical_cast<point>("1,2");
+  EXPECT_EQ(1, p.x);
+  EXPECT_EQ(2, p.y);
+}
+
+TEST(StringUtils, ShouldReadCsvRows) {
+  string_view in{"id,name,note\r\n1,\"a, b\",\"say \"\"hi\"\"\"\n\n2,,\"multi\nline\"\n3\tx"};
+  std::vector<string_view> cells{};
+  std::string scratch{};
+
+  ASSERT_TRUE(read_csv_row(in, ',', cells, scratch));
+  ASSERT_EQ(3u, cells.size());
+  EXPECT_EQ("id", cells[0]);
+  EXPECT_EQ("note", cells[2]);
+
+  ASSERT_TRUE(read_csv_row(in, ',', cells, scratch));
+  ASSERT_EQ(3u, cells.size());
+  EXPECT_EQ("1", cells[0]);
+  EXPECT_EQ("a, b", cells[1]);
+  EXPECT_EQ("say \"hi\"", cells[2]);
+
+  ASSERT_TRUE(read_csv_row(in, ',', cells, scratch));
+  ASSERT_EQ(3u, cells.size());
+  EXPECT_EQ("2", cells[0]);
+  EXPECT_EQ("", cells[1]);
+  EXPECT_EQ("multi\nline", cells[2]);
+
+  ASSERT_TRUE(read_csv_row(in, '\t', cells, scratch));
+  ASSERT_EQ(2u, cells.size());
+  EXPECT_EQ("3", cells[0]);
+  EXPECT_EQ("x", cells[1]);
+
+  EXPECT_FALSE(read_csv_row(in, ',', cells, scratch));
+}
+
 } // detail
 } // v1
 } // testing
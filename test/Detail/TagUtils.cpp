@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "GUnit/Detail/TagUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+using tags = std::vector<std::string>;
+
+TEST(TagUtils, ShouldMatchEverythingWithEmptyExpression) {
+  const tag_expression expression{""};
+  EXPECT_TRUE(expression.empty());
+  EXPECT_TRUE(expression.matches(tags{}));
+  EXPECT_TRUE(expression.matches(tags{"@slow"}));
+  EXPECT_TRUE(expression.may_match(tags{}));
+}
+
+TEST(TagUtils, ShouldMatchTags) {
+  const tag_expression expression{"@smoke and not @slow"};
+  EXPECT_FALSE(expression.empty());
+  EXPECT_TRUE(expression.matches(tags{"@smoke"}));
+  EXPECT_TRUE(expression.matches(tags{"@wip", "@smoke"}));
+  EXPECT_FALSE(expression.matches(tags{}));
+  EXPECT_FALSE(expression.matches(tags{"@slow"}));
+  EXPECT_FALSE(expression.matches(tags{"@smoke", "@slow"}));
+}
+
+TEST(TagUtils, ShouldRespectPrecedenceAndParentheses) {
+  EXPECT_TRUE(tag_expression{"@a or @b and @c"}.matches(tags{"@a"}));
+  EXPECT_FALSE(tag_expression{"(@a or @b) and @c"}.matches(tags{"@a"}));
+  EXPECT_TRUE(tag_expression{"(@a or @b) and @c"}.matches(tags{"@b", "@c"}));
+  EXPECT_TRUE(tag_expression{"not @a and @b"}.matches(tags{"@b"}));
+  EXPECT_FALSE(tag_expression{"not (@a and @b)"}.matches(tags{"@a", "@b"}));
+  EXPECT_TRUE(tag_expression{"not not @a"}.matches(tags{"@a"}));
+  EXPECT_TRUE(tag_expression{"@a and(@b or @c)"}.matches(tags{"@a", "@c"}));
+}
+
+TEST(TagUtils, ShouldCheckWhetherKnownTagsMayMatch) {
+  const tag_expression expression{"@smoke and not @slow"};
+  EXPECT_TRUE(expression.may_match(tags{}));
+  EXPECT_TRUE(expression.may_match(tags{"@smoke"}));
+  EXPECT_FALSE(expression.may_match(tags{"@slow"}));
+  EXPECT_TRUE(tag_expression{"@slow or @smoke"}.may_match(tags{"@wip"}));
+  EXPECT_FALSE(tag_expression{"not @wip"}.may_match(tags{"@wip", "@smoke"}));
+}
+
+TEST(TagUtils, ShouldThrowOnInvalidExpression) {
+  EXPECT_THROW(tag_expression{"@a and"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"@a @b"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"a"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"(@a"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"@a)"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"not"}, std::invalid_argument);
+  EXPECT_THROW(tag_expression{"()"}, std::invalid_argument);
+
+  std::string many{"@0"};
+  for (auto i = 1; i <= tag_expression::MAX_TAGS; ++i) {
+    many += " or @" + std::to_string(i);
+  }
+  EXPECT_THROW(tag_expression{many}, std::invalid_argument);
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,44 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+#include "GUnit/Detail/ThreadUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+TEST(ThreadUtils, ShouldCallExprForEveryIndex) {
+  for (const auto threads : {1u, 2u, 8u}) {
+    std::vector<int> calls(100);
+    parallel_for(calls.size(), [&](std::size_t i) { calls[i]++; }, threads);
+    EXPECT_EQ(std::vector<int>(100, 1), calls);
+  }
+  parallel_for(0, [](std::size_t) { FAIL(); });
+}
+
+TEST(ThreadUtils, ShouldRethrowExceptionOfLowestIndex) {
+  try {
+    parallel_for(100,
+                 [](std::size_t i) {
+                   if (i % 10 == 3) {
+                     throw std::runtime_error{std::to_string(i)};
+                   }
+                 },
+                 4);
+    FAIL();
+  } catch (const std::runtime_error& e) {
+    EXPECT_EQ(std::string{"3"}, e.what());
+  }
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "GUnit/Detail/TimeoutUtils.h"
+
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+TEST(TimeoutUtils, ShouldNotExpireDisarmedDeadline) {
+  { const deadline disabled{0, "disabled"}; }
+  {
+    deadline d{50, "disarmed"};
+    d = {};
+  }
+  { const deadline d{50, "destroyed"}; }
+  std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  SUCCEED();
+}
+
+TEST(TimeoutUtils, ShouldKillForkedChildWhenItsDeadlineExpires) {
+  const auto forked = run_forked([](const std::function<void(const std::string&)>& write) {
+    const deadline d{50, "Step \"hang\""};
+    write("started");
+    for (;;) {
+      sleep(1);
+    }
+  });
+  EXPECT_FALSE(forked.exited);
+  EXPECT_EQ("started", forked.out);
+  EXPECT_EQ("killed by signal 9", forked.status);
+}
+
+TEST(TimeoutUtils, ShouldKillOnlyTheChildWhenDeadlineOfTheWaitingThreadExpires) {
+  const auto begin = std::chrono::steady_clock::now();
+  {
+    const deadline d{50, "Scenario \"hang\""};
+    const auto forked = run_forked_with_deadlines([](const std::function<void(const std::string&)>&) {
+      for (;;) {
+        sleep(1);
+      }
+    });
+    EXPECT_FALSE(forked.exited);
+    EXPECT_EQ("killed by signal 9", forked.status);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds{5});
+  std::this_thread::sleep_for(std::chrono::milliseconds{1200});  // past the grace period, still running
+}
+
+}  // detail
+}  // v1
+}  // testing
@@ -0,0 +1,47 @@
+//
+// Copyright (c) 2016-2017 Kris Jusiak (kris at jusiak dot net)
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "GUnit/Detail/WatchUtils.h"
+
+#if defined(__linux__)
+namespace testing {
+inline namespace v1 {
+namespace detail {
+
+TEST(WatchUtils, ShouldNotifyAboutWrittenFiles) {
+  const std::string a = "WatchUtils.a.feature";
+  const std::string b = "WatchUtils.b.feature";
+  std::ofstream{a} << "a";
+  std::ofstream{b} << "b";
+
+  file_watcher watcher{{a, "./" + b}};
+
+  std::ofstream{"WatchUtils.unrelated"} << "c";
+  std::ofstream{a} << "a2";
+  EXPECT_EQ(std::vector<std::string>{a}, watcher.wait());
+
+  const auto tmp = b + ".tmp";
+  std::ofstream{tmp} << "b2";
+  std::rename(tmp.c_str(), b.c_str());
+  std::ofstream{a} << "a3";
+  EXPECT_EQ((std::vector<std::string>{"./" + b, a}), watcher.wait());
+
+  std::remove(a.c_str());
+  std::remove(b.c_str());
+  std::remove("WatchUtils.unrelated");
+}
+
+}  // detail
+}  // v1
+}  // testing
+#endif
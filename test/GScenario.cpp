@@ -8,6 +8,11 @@
 #include "GUnit/GScenario.h"
 #include "GUnit/GTest.h"
 
+#include <sys/stat.h>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
 namespace testing {
 inline namespace v1 {
 GTEST("Steps") {
@@ -24,13 +29,116 @@ GTEST("Steps") {
   steps.Then("{}", "table") = [](int, const Table&) {};
   steps.Then("{}", "table") = [](const std::string&, const Table&) {};
   steps.$Then("{}", "table") = [](int, Table) {};
+  EXPECT_THROW((void)testing::Steps{steps}, std::invalid_argument);
+}
+
+GTEST("StepRegistry") {
+  SHOULD("reuse compiled steps for the same definitions") {
+    detail::step_registry registry{};
+    const detail::step_definitions_t definitions{{"I press {button}", {}}, {"I have {n}", {}}, {"I have {n}", {}}};
+    const auto compiled = registry.get(definitions);
+    EXPECT_EQ(compiled, registry.get(definitions));
+    EXPECT_EQ((std::vector<std::size_t>{2}), compiled->find("I have 42"));
+    EXPECT_EQ((std::vector<std::size_t>{0}), compiled->find("I press add"));
+
+    const detail::step_definitions_t other{{"I press {button}", {}}};
+    EXPECT_NE(compiled, registry.get(other));
+    EXPECT_EQ(compiled, registry.get(definitions));
+
+    const std::string press = "I press {button}", have = "I have {n}";
+    const detail::step_definitions_t copies{{press.c_str(), {}}, {have.c_str(), {}}, {have.c_str(), {}}};
+    EXPECT_EQ(compiled, registry.get(copies));
+  }
+
+  SHOULD("copy patterns which aren't known at compile time") {
+    detail::step_registry registry{};
+    std::string pattern = "I have {n}";
+    const detail::step_definitions_t first{{pattern.c_str(), {}}};
+    const auto compiled = registry.get(first);
+    pattern.replace(2, 4, "need");  // same address, new text
+    const detail::step_definitions_t second{{pattern.c_str(), {}}};
+    EXPECT_EQ("I have {n}", first.front().pattern);
+    EXPECT_NE(compiled, registry.get(second));
+    EXPECT_EQ((std::vector<std::size_t>{0}), registry.get(second)->find("I need 42"));
+  }
+}
+
+GTEST("Watch") {
+  SHOULD("return right away when no features are watched") { testing::WatchFeatures(); }
+}
+
+GTEST("Feature") {
+  SHOULD("read the header of a feature") {
+    const auto header = detail::read_feature_header(
+        "\xEF\xBB\xBF# language: fr\n# comment\n@smoke @slow # tags\n\nFonctionnalit\xC3\xA9: Calc  \nSc\xC3\xA9nario: ...");
+    EXPECT_EQ("fr", header.language);
+    EXPECT_EQ((std::vector<std::string>{"@smoke", "@slow"}), header.tags);
+    EXPECT_EQ("Calc", header.name);
+
+    EXPECT_EQ("en", detail::read_feature_header("Feature: Calc").language);
+    EXPECT_EQ("", detail::read_feature_header("# only comments").name);
+  }
+
+  SHOULD("find features in directories and globs") {
+    const std::string root = "GScenario.features";
+    for (const auto& directory : {"", "/calc", "/calc/add", "/table"}) {
+      ::mkdir((root + directory).c_str(), 0755);
+    }
+    const std::vector<std::string> files = {"/b.feature", "/a.feature", "/calc/c.feature", "/calc/add/d.feature",
+                                            "/table/e.feature", "/table/e.txt"};
+    for (const auto& file : files) {
+      std::ofstream{root + file} << "Feature: " << file;
+    }
+    const auto path = [&](const std::string& file) { return root + file; };
+    detail::file_cache cache{root + "/features.bin", 1};
+
+    for (auto* c : {static_cast<detail::file_cache*>(nullptr), &cache, &cache}) {
+      EXPECT_EQ((std::vector<std::string>{path("/a.feature"), path("/b.feature"), path("/calc/add/d.feature"),
+                                          path("/calc/c.feature"), path("/table/e.feature")}),
+                detail::find_features({root}, c, 2));
+      EXPECT_EQ((std::vector<std::string>{path("/calc/c.feature"), path("/table/e.feature")}),
+                detail::find_features({root + "/*/*.feature"}, c, 2));
+      EXPECT_EQ((std::vector<std::string>{path("/calc/add/d.feature"), path("/calc/c.feature"), path("/b.feature")}),
+                detail::find_features({root + "/calc/**/*.feature", path("/b.feature"), root + "/calc"}, c, 2));
+      EXPECT_EQ((std::vector<std::string>{"not_found.feature"}), detail::find_features({"not_found.feature"}, c, 2));
+    }
+
+    for (auto it = files.rbegin(); it != files.rend(); ++it) {
+      std::remove(path(*it).c_str());
+    }
+    for (const auto& directory : {"/calc/add", "/calc", "/table", ""}) {
+      std::remove((root + directory).c_str());
+    }
+  }
 }
 
+namespace {
+
+/**
+ * Table of a step of the gherkin compiler output, converted through the pickle like the tables of the run steps
+ */
+Table make_table(nlohmann::json step) {
+  if (not step.count("text")) {
+    step["text"] = "";
+  }
+  if (not step.count("locations")) {
+    nlohmann::json location{};
+    location["line"] = 0;
+    step["locations"] = nlohmann::json::array({location});
+  }
+  nlohmann::json json{};
+  json["steps"] = nlohmann::json::array({step});
+  const detail::pickle pickle{json};
+  return pickle.table(pickle.steps().front());
+}
+
+}  // namespace
+
 GTEST("Table") {
   SHOULD("make empty table from empty json") {
     nlohmann::json json{};
     json["arguments"] = {};
-    EXPECT_TRUE(detail::make_table(json).empty());
+    EXPECT_TRUE(make_table(json).empty());
   }
 
   SHOULD("make one row table from json") {
@@ -88,7 +196,7 @@ GTEST("Table") {
     })"_json;
     // clang-format on
 
-    auto table = detail::make_table(json);
+    auto table = make_table(json);
     ASSERT_EQ(1u, table.size());
     EXPECT_EQ("boz", table[0]["foo"]);
     EXPECT_EQ("boo", table[0]["bar"]);
@@ -167,13 +275,140 @@ GTEST("Table") {
     })"_json;
     // clang-format on
 
-    auto table = detail::make_table(json);
+    auto table = make_table(json);
     ASSERT_EQ(2u, table.size());
     EXPECT_EQ("boz", table[0]["foo"]);
     EXPECT_EQ("boo", table[0]["bar"]);
     EXPECT_EQ("boz2", table[1]["foo"]);
     EXPECT_EQ("boo2", table[1]["bar"]);
   }
+
+
+  SHOULD("make one row table from pickle") {
+    // clang-format off
+    const auto json = R"({
+       "steps":[
+          {
+             "arguments":[
+                {
+                   "rows":[
+                      {"cells":[{"value":"foo"}, {"value":"bar"}]},
+                      {"cells":[{"value":"boz"}, {"value":"boo"}]}
+                   ]
+                }
+             ],
+             "locations":[{"column":11, "line":4}],
+             "text":"a simple data table"
+          }
+       ]
+    })"_json;
+    // clang-format on
+
+    const detail::pickle pickle{json};
+    auto table = pickle.table(pickle.steps()[0]);
+    ASSERT_EQ(1u, table.size());
+    EXPECT_EQ("boz", table[0]["foo"]);
+    EXPECT_EQ("boo", table[0]["bar"]);
+  }
+
+  SHOULD("make steps and tables from pickle") {
+    // clang-format off
+    const auto json = R"({
+       "steps":[
+          {
+             "arguments":[],
+             "locations":[{"column":5, "line":3}],
+             "text":"a step"
+          },
+          {
+             "arguments":[
+                {
+                   "rows":[
+                      {"cells":[{"value":"foo"}, {"value":"bar"}]},
+                      {"cells":[{"value":"boz"}, {"value":"boo"}]},
+                      {"cells":[{"value":"boz2"}, {"value":"boo2"}]}
+                   ]
+                }
+             ],
+             "locations":[{"column":5, "line":4}],
+             "text":"a simple data table"
+          }
+       ]
+    })"_json;
+    // clang-format on
+
+    const detail::pickle pickle{json};
+    ASSERT_EQ(2u, pickle.steps().size());
+    EXPECT_EQ("a step", pickle.str(pickle.steps()[0]));
+    EXPECT_EQ(3, pickle.steps()[0].line);
+    EXPECT_TRUE(pickle.table(pickle.steps()[0]).empty());
+
+    EXPECT_EQ("a simple data table", pickle.str(pickle.steps()[1]));
+    EXPECT_EQ(4, pickle.steps()[1].line);
+    auto table = pickle.table(pickle.steps()[1]);
+    ASSERT_EQ(2u, table.size());
+    EXPECT_EQ("boz", table[0]["foo"]);
+    EXPECT_EQ("boo", table[0]["bar"]);
+    EXPECT_EQ("boz2", table[1]["foo"]);
+    EXPECT_EQ("boo2", table[1]["bar"]);
+  }
+
+  SHOULD("access data table by column index") {
+    const std::string arena = "idnameval1foo";
+    const detail::text cells[] = {{0, 2}, {2, 4}, {6, 3}, {10, 3}};
+    const DataTable table{arena, cells, 2, 2};
+
+    ASSERT_EQ(1u, table.size());
+    EXPECT_EQ(2u, table.columns());
+    EXPECT_EQ("id", table.header(0));
+    EXPECT_EQ(1u, table.column("name"));
+    EXPECT_THROW(table.column("unknown"), std::out_of_range);
+
+    const auto name = table.column("name");
+    auto rows = 0;
+    for (const auto& row : table) {
+      EXPECT_EQ("val", row[0]);
+      EXPECT_EQ("foo", row[name]);
+      ++rows;
+    }
+    EXPECT_EQ(1, rows);
+
+    const Table map = table;
+    ASSERT_EQ(1u, map.size());
+    EXPECT_EQ("val", map[0].at("id"));
+    EXPECT_EQ("foo", map[0].at("name"));
+  }
+
+  SHOULD("stream rows of a data file") {
+    const std::string path = "GScenario.DataFile.csv";
+    {
+      std::ofstream file{path};
+      file << "id,name\n1,\"a, \"\"b\"\"\"\n2,c\n";
+    }
+
+    const auto data = detail::lexical_cast<const DataFile&>(path);
+    EXPECT_EQ(2u, data.columns());
+    EXPECT_EQ("name", data.header(1));
+    EXPECT_EQ(1u, data.column("name"));
+    EXPECT_THROW(data.column("unknown"), std::out_of_range);
+
+    std::vector<std::string> names{};
+    for (const auto& row : data) {
+      ASSERT_EQ(2u, row.size());
+      names.push_back(row["name"].str());
+    }
+    EXPECT_EQ((std::vector<std::string>{"a, \"b\"", "c"}), names);
+
+    auto it = data.begin();
+    const auto copy = it;
+    ++it;
+    EXPECT_EQ("a, \"b\"", (*copy)[1]);
+    EXPECT_EQ("c", (*it)[1]);
+    EXPECT_TRUE(++it == data.end());
+
+    std::remove(path.c_str());
+    EXPECT_THROW(DataFile{path}, std::runtime_error);
+  }
 }
 
 }  // v1
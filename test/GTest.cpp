@@ -844,6 +844,45 @@ GTEST(example, "[Values]", testing::Values(1, 2, 3)) {
   }
 }
 
+TEST(GTest, ShouldGenerateLazyParams) {
+  using namespace testing;
+  const auto range = LazyRange(0, 10, 3);
+  ASSERT_EQ(4u, range.size());
+  EXPECT_EQ(0, range[0]);
+  EXPECT_EQ(9, range[3]);
+
+  const auto fractions = LazyRange(0.0, 1.0, 0.3);
+  ASSERT_EQ(4u, fractions.size());
+  EXPECT_DOUBLE_EQ(0.9, fractions[3]);
+  EXPECT_EQ(0u, LazyRange(1.0, 0.0, 0.3).size());
+
+  const auto values = LazyCombine(LazyRange(0, 3), LazyValues('a', 'b'));
+  ASSERT_EQ(6u, values.size());
+  EXPECT_EQ(std::make_tuple(0, 'a'), values[0]);
+  EXPECT_EQ(std::make_tuple(0, 'b'), values[1]);
+  EXPECT_EQ(std::make_tuple(2, 'b'), values[5]);
+
+  const auto split = values.split(1, 4);
+  ASSERT_EQ(2u, split.size());
+  EXPECT_EQ(values[1], split[0]);
+  EXPECT_EQ(values[5], split[1]);
+  EXPECT_EQ(0u, values.split(6, 4).size());
+
+  std::vector<int> all{};
+  const internal::ParamGenerator<int> generator = range;
+  for (const auto param : generator) {
+    all.push_back(param);
+  }
+  EXPECT_EQ((std::vector<int>{0, 3, 6, 9}), all);
+}
+
+GTEST("LazyParamTest", "[Lazy]", testing::LazyCombine(testing::LazyRange(0, 100), testing::LazyValues('a', 'b'))) {
+  SHOULD("be in range") {
+    EXPECT_TRUE(std::get<0>(GetParam()) >= 0 && std::get<0>(GetParam()) < 100);
+    EXPECT_TRUE(std::get<1>(GetParam()) == 'a' || std::get<1>(GetParam()) == 'b');
+  }
+}
+
 GTEST("Test1") {}
 GTEST("Test1", "Desc1") {}
 GTEST("Test1", "Desc2") {}